@@ -0,0 +1,179 @@
+// Microbenchmarks for BigInt: construction, toString, arithmetic and comparison at sizes
+// from 1 to 10^6 digits, reported as JSON on stdout.
+//
+//   bigint_bench [--seeds=DIR] [--ops=mul,div,...] [--max-digits=N] [--min-time=SECONDS]
+//
+// Operand digits are cut from the numbers in the testcases/bigint-testcases inputs, so runs
+// are reproducible. Each measurement cycles through the four sign combinations.
+#include "BigInt.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <dirent.h>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifndef BIGINT_BENCH_SEED_DIR
+#define BIGINT_BENCH_SEED_DIR "testcases/bigint-testcases"
+#endif
+
+static const size_t SIZES[] = {1, 10, 100, 1000, 10000, 100000, 1000000};
+static const char* const OPS[] = {"construct", "toString", "add", "sub", "mul", "div", "mod", "compare"};
+// Digit runs shorter than this in the seed files are ignored
+static constexpr size_t MIN_SEED_RUN = 20;
+
+struct Options {
+    std::string seedDir = BIGINT_BENCH_SEED_DIR;
+    std::vector<std::string> ops{std::begin(OPS), std::end(OPS)};
+    size_t maxDigits = 1000000;
+    double minTime = 0.2;
+};
+
+// ============== Seed digits ==============
+// All digit runs of the .in files in dir, concatenated in file name order
+static std::string loadSeedDigits(const std::string& dir) {
+    std::vector<std::string> files;
+    if (DIR* d = opendir(dir.c_str())) {
+        while (dirent* e = readdir(d)) {
+            std::string name = e->d_name;
+            if (name.size() > 3 && name.compare(name.size() - 3, 3, ".in") == 0) files.push_back(dir + "/" + name);
+        }
+        closedir(d);
+    }
+    std::sort(files.begin(), files.end());
+    std::string pool, run;
+    for (const auto& f : files) {
+        std::ifstream in(f);
+        std::stringstream ss;
+        ss << in.rdbuf();
+        for (char c : ss.str() + " ") {
+            if (c >= '0' && c <= '9') { run += c; continue; }
+            if (run.size() >= MIN_SEED_RUN) pool += run;
+            run.clear();
+        }
+    }
+    return pool;
+}
+
+// n digits starting at offset in the (wrapped) pool, without a leading zero
+static std::string digitsAt(const std::string& pool, size_t offset, size_t n) {
+    std::string s(n, '0');
+    for (size_t i = 0; i < n; i++) s[i] = pool[(offset + i) % pool.size()];
+    if (s[0] == '0') s[0] = '1' + (char)(offset % 9);
+    return s;
+}
+
+// ============== Timing ==============
+struct Result {
+    std::string op;
+    size_t digits;
+    size_t iterations;
+    double nsPerOp;
+};
+
+// Runs body(i) in batches until minTime has passed; returns the best batch's ns per call
+static Result measure(const std::string& op, size_t digits, double minTime, const std::function<void(size_t)>& body) {
+    using Clock = std::chrono::steady_clock;
+    size_t batch = 1, total = 0;
+    double best = 1e300, spent = 0;
+    while (spent < minTime || total < 4) {
+        auto t0 = Clock::now();
+        for (size_t i = 0; i < batch; i++) body(total + i);
+        double dt = std::chrono::duration<double>(Clock::now() - t0).count();
+        best = std::min(best, dt / batch);
+        total += batch;
+        spent += dt;
+        if (dt < minTime / 10) batch *= 2;
+    }
+    return {op, digits, total, best * 1e9};
+}
+
+static bool wanted(const Options& opt, const std::string& op) {
+    return std::find(opt.ops.begin(), opt.ops.end(), op) != opt.ops.end();
+}
+
+static std::vector<std::string> splitList(const std::string& s) {
+    std::vector<std::string> out;
+    std::stringstream ss(s);
+    for (std::string item; std::getline(ss, item, ',');) {
+        if (!item.empty()) out.push_back(item);
+    }
+    return out;
+}
+
+static Options parseArgs(int argc, char** argv) {
+    Options opt;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        auto value = [&](const char* flag) { return arg.substr(std::string(flag).size()); };
+        if (arg.rfind("--seeds=", 0) == 0) opt.seedDir = value("--seeds=");
+        else if (arg.rfind("--ops=", 0) == 0) opt.ops = splitList(value("--ops="));
+        else if (arg.rfind("--max-digits=", 0) == 0) opt.maxDigits = std::stoull(value("--max-digits="));
+        else if (arg.rfind("--min-time=", 0) == 0) opt.minTime = std::stod(value("--min-time="));
+        else {
+            std::cerr << "usage: bigint_bench [--seeds=DIR] [--ops=a,b] [--max-digits=N] [--min-time=S]\n";
+            std::exit(2);
+        }
+    }
+    return opt;
+}
+
+int main(int argc, char** argv) {
+    Options opt = parseArgs(argc, argv);
+    std::string pool = loadSeedDigits(opt.seedDir);
+    if (pool.empty()) {
+        std::cerr << "bigint_bench: no seed digits found in " << opt.seedDir << "\n";
+        return 1;
+    }
+
+    std::vector<Result> results;
+    size_t sink = 0;  // keeps results observable so no work is optimized away
+    for (size_t digits : SIZES) {
+        if (digits > opt.maxDigits) break;
+        // Four operand pairs, one per sign combination; divisors have half the digits
+        std::vector<std::string> text;
+        std::vector<BigInt> a, b, d;
+        for (size_t k = 0; k < 4; k++) {
+            bool negA = k & 1, negB = k & 2;
+            text.push_back((negA ? "-" : "") + digitsAt(pool, 7919 * k + digits, digits));
+            a.emplace_back(text.back());
+            BigInt y(digitsAt(pool, 104729 * k + 3 * digits, digits));
+            b.push_back(negB ? -y : y);
+            BigInt z(digitsAt(pool, 1299709 * k + 5 * digits, std::max<size_t>(1, digits / 2)));
+            d.push_back(negB ? -z : z);
+        }
+        for (const char* name : OPS) {
+            std::string op = name;
+            if (!wanted(opt, op)) continue;
+            std::function<void(size_t)> body;
+            if (op == "construct") body = [&](size_t i) { sink += BigInt(text[i % 4]).isZero(); };
+            else if (op == "toString") body = [&](size_t i) { sink += a[i % 4].toString().size(); };
+            else if (op == "add") body = [&](size_t i) { sink += (a[i % 4] + b[i % 4]).isZero(); };
+            else if (op == "sub") body = [&](size_t i) { sink += (a[i % 4] - b[i % 4]).isZero(); };
+            else if (op == "mul") body = [&](size_t i) { sink += (a[i % 4] * b[i % 4]).isZero(); };
+            else if (op == "div") body = [&](size_t i) { sink += (a[i % 4] / d[i % 4]).isZero(); };
+            else if (op == "mod") body = [&](size_t i) { sink += (a[i % 4] % d[i % 4]).isZero(); };
+            else if (op == "compare") body = [&](size_t i) { sink += a[i % 4] < b[(i + 1) % 4]; };
+            results.push_back(measure(op, digits, opt.minTime, body));
+            std::cerr << op << " " << digits << " digits: " << results.back().nsPerOp << " ns/op\n";
+        }
+    }
+
+    std::cout << "{\n  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result& r = results[i];
+        char line[256];
+        std::snprintf(line, sizeof(line),
+                      "    {\"op\": \"%s\", \"digits\": %zu, \"signs\": \"mixed\", \"iterations\": %zu, "
+                      "\"ns_per_op\": %.1f, \"ops_per_sec\": %.1f, \"digits_per_sec\": %.1f}%s\n",
+                      r.op.c_str(), r.digits, r.iterations, r.nsPerOp, 1e9 / r.nsPerOp,
+                      1e9 / r.nsPerOp * r.digits, i + 1 < results.size() ? "," : "");
+        std::cout << line;
+    }
+    std::cout << "  ],\n  \"sink\": " << sink << "\n}\n";
+    return 0;
+}
@@ -0,0 +1,387 @@
+#include "BigInt.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+
+// ============== Magnitude kernels ==============
+int BigInt::cmpMag(const Limb* a, size_t an, const Limb* b, size_t bn) {
+    if (an != bn) return an < bn ? -1 : 1;
+    for (size_t i = an; i--;) {
+        if (a[i] != b[i]) return a[i] < b[i] ? -1 : 1;
+    }
+    return 0;
+}
+
+BigInt::Limb BigInt::addMag(Limb* r, const Limb* a, size_t an, const Limb* b, size_t bn) {
+    DLimb carry = 0;
+    size_t i = 0;
+    for (; i < bn; i++) {
+        carry += (DLimb)a[i] + b[i];
+        r[i] = (Limb)carry;
+        carry >>= LIMB_BITS;
+    }
+    for (; i < an; i++) {
+        carry += a[i];
+        r[i] = (Limb)carry;
+        carry >>= LIMB_BITS;
+    }
+    return (Limb)carry;
+}
+
+void BigInt::subMag(Limb* r, const Limb* a, size_t an, const Limb* b, size_t bn) {
+    Limb borrow = 0;
+    size_t i = 0;
+    for (; i < bn; i++) {
+        DLimb d = (DLimb)a[i] - b[i] - borrow;
+        r[i] = (Limb)d;
+        borrow = (Limb)(d >> 63);
+    }
+    for (; i < an; i++) {
+        DLimb d = (DLimb)a[i] - borrow;
+        r[i] = (Limb)d;
+        borrow = (Limb)(d >> 63);
+    }
+}
+
+BigInt::Limb BigInt::mulAddSmall(Limb* a, size_t n, Limb m, Limb c) {
+    DLimb carry = c;
+    for (size_t i = 0; i < n; i++) {
+        carry += (DLimb)a[i] * m;
+        a[i] = (Limb)carry;
+        carry >>= LIMB_BITS;
+    }
+    return (Limb)carry;
+}
+
+BigInt::Limb BigInt::addMulRow(Limb* r, const Limb* a, size_t n, Limb m) {
+    DLimb carry = 0;
+    for (size_t i = 0; i < n; i++) {
+        carry += (DLimb)a[i] * m + r[i];
+        r[i] = (Limb)carry;
+        carry >>= LIMB_BITS;
+    }
+    return (Limb)carry;
+}
+
+BigInt::DLimb BigInt::mulAddWord(Limb* a, size_t n, DLimb m, DLimb c) {
+    unsigned __int128 carry = c;
+    for (size_t i = 0; i < n; i++) {
+        carry += (unsigned __int128)a[i] * m;
+        a[i] = (Limb)carry;
+        carry >>= LIMB_BITS;
+    }
+    return (DLimb)carry;
+}
+
+BigInt BigInt::fromLimbs(const Limb* p, size_t n) {
+    BigInt r;
+    r.mag.assign(p, p + n);
+    r.trim();
+    return r;
+}
+
+BigInt BigInt::fromWord(DLimb w) {
+    BigInt r;
+    if (w) r.mag.push_back((Limb)w);
+    if (w >> LIMB_BITS) r.mag.push_back((Limb)(w >> LIMB_BITS));
+    return r;
+}
+
+BigInt::DLimb BigInt::lowWord() const {
+    DLimb w = mag.empty() ? 0 : mag[0];
+    if (mag.size() > 1) w |= (DLimb)mag[1] << LIMB_BITS;
+    return w;
+}
+
+BigInt BigInt::concatLimbs(const BigInt& hi, const BigInt& lo, size_t n) {
+    BigInt r;
+    if (hi.isZero()) { r.mag = lo.mag; return r; }
+    r.mag.reserve(n + hi.mag.size());
+    r.mag = lo.mag;
+    r.mag.resize(n + hi.mag.size(), 0);
+    std::copy(hi.mag.begin(), hi.mag.end(), r.mag.begin() + n);
+    return r;
+}
+
+BigInt BigInt::lowLimbs(size_t n) const {
+    return fromLimbs(mag.data(), std::min(n, mag.size()));
+}
+
+BigInt BigInt::shiftedLeft(size_t bits) const {
+    BigInt r;
+    if (isZero()) return r;
+    size_t limbs = bits / LIMB_BITS;
+    int s = bits % LIMB_BITS;
+    r.mag.assign(limbs + mag.size() + 1, 0);
+    for (size_t i = 0; i < mag.size(); i++) {
+        r.mag[limbs + i] |= mag[i] << s;
+        if (s) r.mag[limbs + i + 1] = mag[i] >> (LIMB_BITS - s);
+    }
+    r.trim();
+    return r;
+}
+
+BigInt BigInt::shiftedRight(size_t bits) const {
+    BigInt r;
+    size_t limbs = bits / LIMB_BITS;
+    if (limbs >= mag.size()) return r;
+    int s = bits % LIMB_BITS;
+    r.mag.resize(mag.size() - limbs);
+    for (size_t i = 0; i < r.mag.size(); i++) {
+        r.mag[i] = mag[limbs + i] >> s;
+        if (s && limbs + i + 1 < mag.size()) r.mag[i] |= mag[limbs + i + 1] << (LIMB_BITS - s);
+    }
+    r.trim();
+    return r;
+}
+
+size_t BigInt::bitLength() const {
+    if (isZero()) return 0;
+    return mag.size() * LIMB_BITS - __builtin_clz(mag.back());
+}
+
+void BigInt::incMag() {
+    Limb one = 1;
+    if (mag.empty() || addMag(mag.data(), mag.data(), mag.size(), &one, 1)) mag.push_back(1);
+}
+
+void BigInt::trim() {
+    while (!mag.empty() && std::as_const(mag).back() == 0) mag.pop_back();  // reading must not unshare
+    if (mag.empty()) negative = false;
+}
+
+// ============== Construction and conversion ==============
+BigInt::BigInt(long long n) {
+    negative = n < 0;
+    unsigned long long u = negative ? 0ULL - (unsigned long long)n : (unsigned long long)n;
+    while (u) { mag.push_back((Limb)u); u >>= LIMB_BITS; }
+}
+
+// Range of the preconstructed values handed out by cached()
+static constexpr long long CACHED_MIN = -16, CACHED_MAX = 256;
+
+const BigInt* BigInt::cached(long long v) {
+    static const std::vector<BigInt> table = [] {
+        std::vector<BigInt> t;
+        for (long long i = CACHED_MIN; i <= CACHED_MAX; i++) t.emplace_back(i);
+        return t;
+    }();
+    if (v < CACHED_MIN || v > CACHED_MAX) return nullptr;
+    return &table[v - CACHED_MIN];
+}
+
+long long BigInt::toLong() const {
+    unsigned long long r = lowWord();
+    return (long long)(negative ? 0ULL - r : r);  // negated unsigned, so -2^63 is not an overflow
+}
+
+bool BigInt::fitsLong() const {
+    if (mag.size() > 2) return false;
+    unsigned long long r = lowWord();
+    return r <= (unsigned long long)INT64_MAX || (negative && r == (unsigned long long)INT64_MAX + 1);
+}
+
+// The top 64 bits, with every lower bit folded into the last one so the conversion to
+// double still rounds ties correctly
+double BigInt::toDouble() const {
+    size_t bits = bitLength();
+    if (bits <= 64) {
+        double d = (double)lowWord();
+        return negative ? -d : d;
+    }
+    size_t shift = bits - 64;
+    const Limb* p = mag.data();
+    size_t i = shift / LIMB_BITS;
+    int s = shift % LIMB_BITS;
+    unsigned __int128 w = 0;
+    for (size_t k = 0; k < 3 && i + k < mag.size(); k++) w |= (unsigned __int128)p[i + k] << (LIMB_BITS * k);
+    DLimb top = (DLimb)(w >> s);
+    bool sticky = (s && (p[i] & ((Limb(1) << s) - 1))) ||
+                  std::any_of(p, p + i, [](Limb x) { return x != 0; });
+    double m = (double)(top | sticky);  // in [2^63, 2^64]
+    // Decided on the exponent: -Ofast assumes no infinities, so isinf() cannot be trusted
+    if (bits > 1024 || (bits == 1024 && m == 0x1p64)) throw std::runtime_error("int too large to convert to float");
+    double d = std::ldexp(m, (int)shift);
+    return negative ? -d : d;
+}
+
+// ============== Operators ==============
+BigInt BigInt::operator-() const {
+    BigInt r = *this;
+    if (!isZero()) r.negative = !r.negative;
+    return r;
+}
+
+BigInt BigInt::operator+(const BigInt& o) const {
+    const BigInt* x = this;
+    const BigInt* y = &o;
+    if (mag.size() < o.mag.size()) std::swap(x, y);
+    BigInt r;
+    if (negative == o.negative) {
+        r.mag.resize(x->mag.size() + 1);
+        r.mag.back() = addMag(r.mag.data(), x->mag.data(), x->mag.size(), y->mag.data(), y->mag.size());
+        r.negative = negative;
+    } else {
+        int c = cmpMag(x->mag.data(), x->mag.size(), y->mag.data(), y->mag.size());
+        if (c == 0) return BigInt(0);
+        if (c < 0) std::swap(x, y);
+        r.mag.resize(x->mag.size());
+        subMag(r.mag.data(), x->mag.data(), x->mag.size(), y->mag.data(), y->mag.size());
+        r.negative = x->negative;
+    }
+    r.trim();
+    return r;
+}
+
+BigInt BigInt::operator-(const BigInt& o) const {
+    return *this + (-o);
+}
+
+BigInt BigInt::operator*(const BigInt& o) const {
+    if (isZero() || o.isZero()) return BigInt(0);
+    BigInt r;
+    r.mag.resize(mag.size() + o.mag.size());
+    mulMag(r.mag.data(), mag.data(), mag.size(), o.mag.data(), o.mag.size());
+    r.negative = (negative != o.negative);
+    r.trim();
+    return r;
+}
+
+void BigInt::divMod(const BigInt& a, const BigInt& b, BigInt& q, BigInt& r) {
+    divModMag(a, b, q, r);
+    bool qneg = (a.negative != b.negative);
+    if (qneg && !r.isZero()) {  // round the quotient toward -inf: q += 1, r = |b| - r
+        q.incMag();
+        size_t rn = r.mag.size();
+        r.mag.resize(b.mag.size(), 0);
+        subMag(r.mag.data(), b.mag.data(), b.mag.size(), r.mag.data(), rn);
+        r.trim();
+    }
+    q.negative = qneg && !q.isZero();
+    r.negative = b.negative && !r.isZero();
+}
+
+BigInt BigInt::operator/(const BigInt& o) const {
+    BigInt q, r;
+    divMod(*this, o, q, r);
+    return q;
+}
+
+BigInt BigInt::operator%(const BigInt& o) const {
+    if (o.mag.size() == 1 || o.mag.size() == 2) {  // one-word divisor: remainder only, no quotient stored
+        DLimb d = o.lowWord(), rem = divSmall(nullptr, mag.data(), mag.size(), d);
+        if (rem && negative != o.negative) rem = d - rem;
+        BigInt r = fromWord(rem);
+        r.negative = o.negative && rem;
+        return r;
+    }
+    BigInt q, r;
+    divMod(*this, o, q, r);
+    return r;
+}
+
+bool BigInt::operator<(const BigInt& o) const {
+    if (negative != o.negative) return negative;
+    int c = cmpMag(mag.data(), mag.size(), o.mag.data(), o.mag.size());
+    return negative ? c > 0 : c < 0;
+}
+bool BigInt::operator>(const BigInt& o) const { return o < *this; }
+bool BigInt::operator<=(const BigInt& o) const { return !(o < *this); }
+bool BigInt::operator>=(const BigInt& o) const { return !(*this < o); }
+bool BigInt::operator==(const BigInt& o) const { return negative == o.negative && mag == o.mag; }
+bool BigInt::operator!=(const BigInt& o) const { return !(*this == o); }
+
+// ============== Compound assignment ==============
+// These update the existing limb buffer instead of building a temporary, so accumulator
+// loops only reallocate when the value outgrows its capacity.
+void BigInt::addSigned(const BigInt& o, bool oNeg) {
+    size_t n = mag.size(), on = o.mag.size();
+    if (on == 0) return;
+    if (n == 0) { mag = o.mag; negative = oNeg; return; }
+    if (negative == oNeg) {
+        if (n < on) mag.resize(on, 0);
+        Limb carry = addMag(mag.data(), mag.data(), mag.size(), o.mag.data(), on);
+        if (carry) mag.push_back(carry);
+        return;
+    }
+    int c = cmpMag(mag.data(), n, o.mag.data(), on);
+    if (c == 0) { mag.clear(); negative = false; return; }
+    if (c > 0) {
+        subMag(mag.data(), mag.data(), n, o.mag.data(), on);
+    } else {
+        mag.resize(on, 0);
+        subMag(mag.data(), o.mag.data(), on, mag.data(), n);
+        negative = oNeg;
+    }
+    trim();
+}
+
+BigInt& BigInt::operator+=(const BigInt& o) { addSigned(o, o.negative); return *this; }
+BigInt& BigInt::operator-=(const BigInt& o) { addSigned(o, !o.negative && !o.isZero()); return *this; }
+
+BigInt& BigInt::operator*=(const BigInt& o) {
+    if (isZero() || o.isZero()) { mag.clear(); negative = false; return *this; }
+    bool neg = (negative != o.negative);
+    if (o.mag.size() == 1) {
+        Limb carry = mulAddSmall(mag.data(), mag.size(), o.mag[0], 0);
+        if (carry) mag.push_back(carry);
+    } else {
+        LimbVector r(mag.size() + o.mag.size());
+        mulMag(r.data(), mag.data(), mag.size(), o.mag.data(), o.mag.size());
+        mag.swap(r);
+        trim();
+    }
+    negative = neg;
+    return *this;
+}
+
+// Rows of a schoolbook product are added straight into the accumulator while the shorter
+// factor stays below this many limbs and the signs agree; otherwise the product goes
+// through a scratch value and a signed add.
+static constexpr size_t ADDMUL_ROW_LIMBS = 16;
+
+void BigInt::addProduct(const BigInt& a, const BigInt& b, bool neg) {
+    if (a.isZero() || b.isZero()) return;
+    bool pneg = (a.negative != b.negative) != neg;
+    const BigInt *x = &a, *y = &b;
+    if (x->mag.size() < y->mag.size()) std::swap(x, y);
+    size_t xn = x->mag.size(), yn = y->mag.size(), pn = xn + yn;
+    if ((isZero() || negative == pneg) && yn < ADDMUL_ROW_LIMBS && this != x && this != y) {
+        size_t n = std::max(mag.size(), pn) + 1;  // |this| + |a * b| fits
+        mag.resize(n, 0);
+        Limb* r = mag.data();
+        const Limb *xp = x->mag.data(), *yp = y->mag.data();
+        for (size_t i = 0; i < yn; i++) {
+            Limb carry = addMulRow(r + i, xp, xn, yp[i]);
+            for (size_t k = i + xn; carry; k++) {
+                DLimb s = (DLimb)r[k] + carry;
+                r[k] = (Limb)s;
+                carry = (Limb)(s >> LIMB_BITS);
+            }
+        }
+        negative = pneg;
+        trim();
+        return;
+    }
+    BigInt p;
+    p.mag.resize(pn);
+    mulMag(p.mag.data(), x->mag.data(), xn, y->mag.data(), yn);
+    p.trim();
+    addSigned(p, pneg);
+}
+
+void BigInt::addMul(const BigInt& a, const BigInt& b) { addProduct(a, b, false); }
+void BigInt::subMul(const BigInt& a, const BigInt& b) { addProduct(a, b, true); }
+
+BigInt& BigInt::operator/=(const BigInt& o) {
+    if (o.mag.size() != 1 && o.mag.size() != 2) { *this = *this / o; return *this; }
+    bool neg = (negative != o.negative);
+    DLimb rem = divSmall(mag.data(), mag.data(), mag.size(), o.lowWord());
+    trim();
+    if (neg && rem) incMag();  // floor division rounds the magnitude up
+    negative = neg && !mag.empty();
+    return *this;
+}
+
+BigInt& BigInt::operator%=(const BigInt& o) { *this = *this % o; return *this; }
@@ -0,0 +1,121 @@
+#pragma once
+#ifndef PYTHON_INTERPRETER_BIGINT_H
+#define PYTHON_INTERPRETER_BIGINT_H
+
+#include "LimbVector.h"
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Arbitrary precision integer: sign + magnitude stored as base 2^32 limbs
+class BigInt {
+public:
+    using Limb = uint32_t;
+    using DLimb = uint64_t;
+    static constexpr int LIMB_BITS = 32;
+
+    BigInt() : negative(false) {}
+    BigInt(long long n);
+    explicit BigInt(const std::string& s);  // [spaces][sign]digits; throws on anything else
+
+    static const BigInt* cached(long long v);  // shared instance for small v, else null
+
+    std::string toString() const;
+    long long toLong() const;  // for int() conversion when in range
+    bool fitsLong() const;  // value representable as long long
+    double toDouble() const;  // nearest double, ties to even; throws when out of range
+    bool isZero() const { return mag.empty(); }
+    bool isNegative() const { return negative; }
+    size_t limbCount() const { return mag.size(); }  // 32-bit limbs in the magnitude
+
+    BigInt operator-() const;
+    BigInt operator+(const BigInt& o) const;
+    BigInt operator-(const BigInt& o) const;
+    BigInt operator*(const BigInt& o) const;
+    BigInt operator/(const BigInt& o) const;  // floor division
+    BigInt operator%(const BigInt& o) const;  // floor modulo, takes the sign of o
+
+    // Floor division and modulo from a single division: a = q * b + r, r has the sign of b.
+    // q and r must not alias a or b.
+    static void divMod(const BigInt& a, const BigInt& b, BigInt& q, BigInt& r);
+
+    // Number theory (BigIntMath.cpp)
+    BigInt abs() const;
+    BigInt pow(unsigned long long e) const;  // this ** e
+    // base ** e mod m for e >= 0 and m != 0; like %, the result takes the sign of m
+    static BigInt powMod(const BigInt& base, const BigInt& e, const BigInt& m);
+    static BigInt gcd(const BigInt& a, const BigInt& b);  // never negative; gcd(0, 0) = 0
+    BigInt isqrt() const;  // floor of the square root; throws for negative values
+
+    bool operator<(const BigInt& o) const;
+    bool operator>(const BigInt& o) const;
+    bool operator<=(const BigInt& o) const;
+    bool operator>=(const BigInt& o) const;
+    bool operator==(const BigInt& o) const;
+    bool operator!=(const BigInt& o) const;
+
+    BigInt& operator+=(const BigInt& o);
+    BigInt& operator-=(const BigInt& o);
+    BigInt& operator*=(const BigInt& o);
+    BigInt& operator/=(const BigInt& o);
+    BigInt& operator%=(const BigInt& o);
+    // Multiply-accumulate into this value's own buffer: this += a * b, this -= a * b.
+    // Short products are added row by row without materializing a * b.
+    void addMul(const BigInt& a, const BigInt& b);
+    void subMul(const BigInt& a, const BigInt& b);
+
+private:
+    bool negative;
+    LimbVector mag;  // absolute value, least significant limb first, no high zero limbs
+
+    void trim();
+    void addSigned(const BigInt& o, bool oNeg);  // this += (oNeg ? -|o| : |o|), in place
+    void incMag();  // |this| += 1
+    void addProduct(const BigInt& a, const BigInt& b, bool neg);  // this += (neg ? -1 : 1) * a * b
+
+    // Magnitude kernels on raw limb ranges (least significant first)
+    static int cmpMag(const Limb* a, size_t an, const Limb* b, size_t bn);
+    static Limb addMag(Limb* r, const Limb* a, size_t an, const Limb* b, size_t bn);  // an >= bn, returns carry
+    static void subMag(Limb* r, const Limb* a, size_t an, const Limb* b, size_t bn);  // a >= b
+    static Limb mulAddSmall(Limb* a, size_t n, Limb m, Limb c);  // a = a * m + c, returns carry
+    static Limb addMulRow(Limb* r, const Limb* a, size_t n, Limb m);  // r += a * m over n limbs, returns carry
+    static DLimb mulAddWord(Limb* a, size_t n, DLimb m, DLimb c);  // same with a one-word multiplier
+    static BigInt fromLimbs(const Limb* p, size_t n);
+    static BigInt fromWord(DLimb w);
+    DLimb lowWord() const;  // |this| mod 2^64
+    static BigInt concatLimbs(const BigInt& hi, const BigInt& lo, size_t n);  // hi * 2^(32n) + lo, lo < 2^(32n)
+    BigInt lowLimbs(size_t n) const;  // |this| mod 2^(32n)
+    BigInt shiftedLeft(size_t bits) const;  // |this| << bits
+    BigInt shiftedRight(size_t bits) const;  // |this| >> bits
+    size_t bitLength() const;
+
+    // Multiplication engine (BigIntMul.cpp); r has an + bn limbs and must not alias a or b
+    static void mulMag(Limb* r, const Limb* a, size_t an, const Limb* b, size_t bn);
+    static void mulSchool(Limb* r, const Limb* a, size_t an, const Limb* b, size_t bn);
+    static void mulUnbalanced(Limb* r, const Limb* a, size_t an, const Limb* b, size_t bn);
+    static void mulKaratsuba(Limb* r, const Limb* a, size_t an, const Limb* b, size_t bn);
+    static void mulToom3(Limb* r, const Limb* a, size_t an, const Limb* b, size_t bn);
+    static void mulNtt(Limb* r, const Limb* a, size_t an, const Limb* b, size_t bn);
+
+    // Division engine (BigIntDiv.cpp); all on magnitudes, quotient truncated
+    static void divModMag(const BigInt& a, const BigInt& b, BigInt& q, BigInt& r);
+    static DLimb divSmall(Limb* q, const Limb* a, size_t n, DLimb d);  // d < 2^64, returns remainder; q may alias a or be null
+    static void divMag(Limb* q, Limb* r, const Limb* a, size_t an, const Limb* b, size_t bn);  // an >= bn >= 2
+    static void divKnuth(const BigInt& a, const BigInt& b, BigInt& q, BigInt& r);
+    static void divBurnikelZiegler(const BigInt& a, const BigInt& b, BigInt& q, BigInt& r);
+    static void div2n1n(const BigInt& a, const BigInt& b, size_t n, BigInt& q, BigInt& r);
+    static void div3n2n(const BigInt& a, const BigInt& b, size_t n, BigInt& q, BigInt& r);
+
+    // Montgomery product for powMod: r = a * b / 2^(32n) mod m, m odd with n limbs, a, b < m.
+    // minv = -1 / m mod 2^32; t is scratch of n + 2 limbs; r may alias a or b.
+    static void montMul(Limb* r, const Limb* a, const Limb* b, const Limb* m, size_t n, Limb minv, Limb* t);
+    static BigInt powModMontgomery(const BigInt& base, const BigInt& e, const BigInt& m);  // m odd, base < m
+
+    // Radix conversion (BigIntConv.cpp): divide and conquer over powers 10^(9 * 2^k)
+    static const BigInt& pow5Pow2(size_t k);
+    static BigInt parseDecimal(const char* s, size_t len);
+    static void writeDecimal(const BigInt& x, char* out, size_t width);  // exactly width digits, zero-padded
+};
+
+#endif
@@ -0,0 +1,142 @@
+#include "BigInt.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <deque>
+#include <mutex>
+#include <stdexcept>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Below these sizes the quadratic chunk-per-pass loops beat splitting
+static constexpr size_t PARSE_BASECASE_DIGITS = 400;
+static constexpr uint64_t TEN_POW_16 = 10000000000000000ULL;
+static constexpr size_t WRITE_BASECASE_DIGITS = 300;
+// From this many digits the two halves of a split are written on the thread pool, if running
+static constexpr size_t PARALLEL_WRITE_DIGITS = 100000;
+
+// 5^(9 * 2^k), squared up on demand and kept for the lifetime of the process.
+// 10^d is handled as 5^d << d, which keeps every product and division about 30% shorter.
+// Entries never move once added, so the returned reference outlives the lock.
+const BigInt& BigInt::pow5Pow2(size_t k) {
+    static std::mutex lock;
+    static std::deque<BigInt> table;
+    std::lock_guard<std::mutex> lk(lock);
+    if (table.empty()) table.push_back(BigInt(1953125LL));
+    while (table.size() <= k) table.push_back(table.back() * table.back());
+    return table[k];
+}
+
+// Smallest k with 9 * 2^(k+1) >= digits: both halves then fit in 9 * 2^k digits, and
+// every lower split lands exactly on the next power down the table
+static size_t splitLevel(size_t digits) {
+    size_t k = 0;
+    while (9 * (size_t(2) << k) < digits) k++;
+    return k;
+}
+
+[[noreturn]] static void invalidLiteral() {
+    throw std::runtime_error("invalid literal for int()");
+}
+
+// Value of up to 16 ASCII digits, checking each one
+static uint64_t parseDigitsScalar(const char* s, size_t n) {
+    uint64_t v = 0;
+    for (size_t i = 0; i < n; i++) {
+        unsigned d = (unsigned char)s[i] - '0';
+        if (d > 9) invalidLiteral();
+        v = v * 10 + d;
+    }
+    return v;
+}
+
+// Value of exactly 16 ASCII digits. With SSE2 the digits are validated together and
+// combined pairwise (2, 4, 8 digits per lane) instead of one multiply per character.
+static uint64_t parseDigits16(const char* s) {
+#if defined(__SSE2__)
+    __m128i v = _mm_sub_epi8(_mm_loadu_si128((const __m128i*)s), _mm_set1_epi8('0'));
+    // Bytes outside '0'..'9' wrapped to above 9 as unsigned values
+    __m128i bad = _mm_cmpeq_epi8(_mm_max_epu8(v, _mm_set1_epi8(9)), _mm_set1_epi8(9));
+    if (_mm_movemask_epi8(bad) != 0xFFFF) invalidLiteral();
+    // Each 16-bit lane holds a leading digit in its low byte and the next one above it
+    __m128i pairs = _mm_add_epi16(_mm_mullo_epi16(_mm_and_si128(v, _mm_set1_epi16(0xFF)), _mm_set1_epi16(10)),
+                                  _mm_srli_epi16(v, 8));
+    __m128i quads = _mm_madd_epi16(pairs, _mm_set_epi16(1, 100, 1, 100, 1, 100, 1, 100));
+    __m128i octs = _mm_madd_epi16(_mm_packs_epi32(quads, quads), _mm_set_epi16(1, 10000, 1, 10000, 1, 10000, 1, 10000));
+    uint64_t hi = (uint32_t)_mm_cvtsi128_si32(octs), lo = (uint32_t)_mm_cvtsi128_si32(_mm_srli_si128(octs, 4));
+    return hi * 100000000 + lo;
+#else
+    return parseDigitsScalar(s, 16);
+#endif
+}
+
+BigInt BigInt::parseDecimal(const char* s, size_t len) {
+    BigInt r;
+    if (len <= PARSE_BASECASE_DIGITS) {
+        // Leading partial chunk, then mag = mag * 10^16 + chunk for each 16 digits
+        size_t head = len % 16;
+        r = fromWord(parseDigitsScalar(s, head));
+        r.mag.reserve(len / 9 + 2);
+        for (size_t i = head; i < len; i += 16) {
+            DLimb carry = mulAddWord(r.mag.data(), r.mag.size(), TEN_POW_16, parseDigits16(s + i));
+            r.mag.push_back((Limb)carry);
+            r.mag.push_back((Limb)(carry >> LIMB_BITS));
+            r.trim();
+        }
+        return r;
+    }
+    size_t k = splitLevel(len), d = 9 * (size_t(1) << k);
+    r = (parseDecimal(s, len - d) * pow5Pow2(k)).shiftedLeft(d);
+    r += parseDecimal(s + len - d, d);
+    return r;
+}
+
+void BigInt::writeDecimal(const BigInt& x, char* out, size_t width) {
+    if (width <= WRITE_BASECASE_DIGITS) {
+        // Peel off 18 decimal digits per pass by short division with 10^18
+        LimbVector cur = x.mag;
+        char* p = out + width;
+        while (!cur.empty()) {
+            DLimb chunk = divSmall(cur.data(), cur.data(), cur.size(), 1000000000000000000ULL);
+            while (!cur.empty() && cur.back() == 0) cur.pop_back();
+            for (int i = 0; i < 18 && p > out; i++, chunk /= 10) *--p = char('0' + chunk % 10);
+        }
+        std::fill(out, p, '0');
+        return;
+    }
+    // x = q * 10^d + r with q = (x >> d) / 5^d and r = ((x >> d) % 5^d) << d | (x mod 2^d)
+    size_t k = splitLevel(width), d = 9 * (size_t(1) << k);
+    BigInt q, r;
+    divModMag(x.shiftedRight(d), pow5Pow2(k), q, r);
+    r = r.shiftedLeft(d);
+    size_t low = d / LIMB_BITS;
+    r.mag.resize(std::max(r.mag.size(), low + 1), 0);
+    std::copy(x.mag.begin(), x.mag.begin() + std::min(low, x.mag.size()), r.mag.begin());
+    if (d % LIMB_BITS && low < x.mag.size()) r.mag[low] |= x.mag[low] & ((Limb(1) << (d % LIMB_BITS)) - 1);
+    r.trim();
+    // The halves fill disjoint slices of out
+    ThreadPool::invoke({[&] { writeDecimal(q, out, width - d); }, [&] { writeDecimal(r, out + width - d, d); }},
+                       width >= PARALLEL_WRITE_DIGITS);
+}
+
+BigInt::BigInt(const std::string& s) : negative(false) {
+    size_t i = s.find_first_not_of(' ');
+    if (i == std::string::npos) invalidLiteral();
+    bool neg = s[i] == '-';
+    if (s[i] == '-' || s[i] == '+') i++;
+    if (i == s.size()) invalidLiteral();
+    *this = parseDecimal(s.data() + i, s.size() - i);
+    negative = neg;
+    trim();
+}
+
+std::string BigInt::toString() const {
+    if (isZero()) return "0";
+    // log10(2) < 0.30103, so this is never short; extra leading zeros are cut below
+    size_t width = bitLength() * 30103 / 100000 + 1;
+    std::string res(width, '0');
+    writeDecimal(*this, &res[0], width);
+    res.erase(0, res.find_first_not_of('0'));
+    if (negative) res.insert(res.begin(), '-');
+    return res;
+}
@@ -0,0 +1,219 @@
+#include "BigInt.h"
+#include <algorithm>
+#include <stdexcept>
+
+// Divisor size (in limbs) from which Burnikel-Ziegler recursion beats Algorithm D;
+// the quotient must be at least this long too, otherwise D's linear-per-limb cost wins.
+static constexpr size_t BZ_THRESHOLD = 64;
+// Normalized divisors remembered per thread for repeated division by the same value
+static constexpr size_t DIVISOR_CACHE_SIZE = 4;
+
+void BigInt::divModMag(const BigInt& a, const BigInt& b, BigInt& q, BigInt& r) {
+    if (b.isZero()) throw std::runtime_error("division by zero");
+    if (cmpMag(a.mag.data(), a.mag.size(), b.mag.data(), b.mag.size()) < 0) {
+        q = BigInt();
+        r = a;
+        r.negative = false;
+        return;
+    }
+    size_t an = a.mag.size(), bn = b.mag.size();
+    if (bn >= BZ_THRESHOLD && an - bn >= BZ_THRESHOLD) divBurnikelZiegler(a, b, q, r);
+    else divKnuth(a, b, q, r);
+}
+
+// ============== Reciprocal division steps ==============
+// Dividing by an invariant normalized 64-bit word d with a precomputed reciprocal costs two
+// multiplies per step instead of a hardware divide: N. Moller, T. Granlund, "Improved
+// division by invariant integers", IEEE Trans. Computers 60(2), 2011, algorithm 4.
+using U128 = unsigned __int128;
+
+static inline uint64_t reciprocalWord(uint64_t d) {
+    return (uint64_t)(~(U128)0 / d);  // floor((2^128 - 1) / d) - 2^64
+}
+
+// (hi * 2^64 + lo) / d with hi < d; stores the remainder in rem
+static inline uint64_t divStep(uint64_t hi, uint64_t lo, uint64_t d, uint64_t v, uint64_t& rem) {
+    U128 p = (U128)v * hi + (((U128)hi << 64) | lo);
+    uint64_t q = (uint64_t)(p >> 64) + 1;
+    uint64_t r = lo - q * d;
+    if (r > (uint64_t)p) { q--; r += d; }
+    if (r >= d) { q++; r -= d; }
+    rem = r;
+    return q;
+}
+
+// Algorithm D runs on the divisor shifted so its top bit is set, with the reciprocal of its
+// top two limbs. Modular loops divide by the same value over and over, and Burnikel-Ziegler
+// base cases reuse one divisor per level, so the last few are kept per thread.
+namespace {
+struct NormalizedDivisor {
+    std::vector<BigInt::Limb> b, vn;
+    int shift = 0;
+    uint64_t inv = 0;
+};
+}
+
+static const NormalizedDivisor& normalizedDivisor(const BigInt::Limb* b, size_t bn) {
+    thread_local NormalizedDivisor cache[DIVISOR_CACHE_SIZE];  // most recently used first
+    for (size_t i = 0; i < DIVISOR_CACHE_SIZE; i++) {
+        if (cache[i].b.size() != bn || !std::equal(b, b + bn, cache[i].b.begin())) continue;
+        std::rotate(cache, cache + i, cache + i + 1);
+        return cache[0];
+    }
+    std::rotate(cache, cache + DIVISOR_CACHE_SIZE - 1, cache + DIVISOR_CACHE_SIZE);
+    NormalizedDivisor& e = cache[0];
+    int s = __builtin_clz(b[bn - 1]);
+    e.b.assign(b, b + bn);
+    e.vn.resize(bn);
+    for (size_t i = bn - 1; i > 0; i--)
+        e.vn[i] = s ? (b[i] << s) | (b[i - 1] >> (BigInt::LIMB_BITS - s)) : b[i];
+    e.vn[0] = b[0] << s;
+    e.shift = s;
+    e.inv = reciprocalWord(((uint64_t)e.vn[bn - 1] << BigInt::LIMB_BITS) | e.vn[bn - 2]);
+    return e;
+}
+
+// Short division by a one-word divisor in a single pass over 64-bit words (limb pairs)
+BigInt::DLimb BigInt::divSmall(Limb* q, const Limb* a, size_t n, DLimb d) {
+    if (n == 0) return 0;
+    int s = __builtin_clzll(d);
+    DLimb dn = d << s, v = reciprocalWord(dn);
+    auto word = [&](size_t j) -> DLimb {
+        DLimb hi = 2 * j + 1 < n ? a[2 * j + 1] : 0;
+        return (hi << LIMB_BITS) | a[2 * j];
+    };
+    size_t words = (n + 1) / 2;
+    DLimb w = word(words - 1);
+    DLimb rem = s ? w >> (64 - s) : 0;
+    for (size_t j = words; j--;) {
+        DLimb next = j ? word(j - 1) : 0;  // read before q[2j..] is written, so q may alias a
+        DLimb qw = divStep(rem, s ? (w << s) | (next >> (64 - s)) : w, dn, v, rem);
+        if (q) {
+            q[2 * j] = (Limb)qw;
+            if (2 * j + 1 < n) q[2 * j + 1] = (Limb)(qw >> LIMB_BITS);
+        }
+        w = next;
+    }
+    return rem >> s;
+}
+
+// Knuth, TAOCP vol. 2, 4.3.1 Algorithm D. q gets an - bn + 1 limbs, r gets bn limbs.
+// Each quotient limb is estimated by dividing the top three remainder limbs by the top two
+// divisor limbs, which is never too small and at most one too large.
+void BigInt::divMag(Limb* q, Limb* r, const Limb* a, size_t an, const Limb* b, size_t bn) {
+    const NormalizedDivisor& nd = normalizedDivisor(b, bn);
+    const Limb* vn = nd.vn.data();
+    int s = nd.shift;
+    DLimb dtop = ((DLimb)vn[bn - 1] << LIMB_BITS) | vn[bn - 2];
+    LimbVector ubuf(an + 1);
+    Limb* un = ubuf.data();
+    un[an] = s ? a[an - 1] >> (LIMB_BITS - s) : 0;
+    for (size_t i = an - 1; i > 0; i--)
+        un[i] = s ? (a[i] << s) | (a[i - 1] >> (LIMB_BITS - s)) : a[i];
+    un[0] = a[0] << s;
+
+    for (size_t j = an - bn + 1; j--;) {
+        DLimb rem, lo = ((DLimb)un[j + bn - 1] << LIMB_BITS) | un[j + bn - 2];
+        DLimb qhat = std::min<DLimb>(divStep(un[j + bn], lo, dtop, nd.inv, rem), 0xFFFFFFFFu);
+        DLimb carry = 0;  // product high part plus borrow, always below 2^32
+        for (size_t i = 0; i < bn; i++) {
+            DLimb p = qhat * vn[i] + carry;
+            Limb lo = (Limb)p, u = un[i + j];
+            un[i + j] = u - lo;
+            carry = (p >> LIMB_BITS) + (u < lo);
+        }
+        bool overshot = un[j + bn] < carry;
+        un[j + bn] -= (Limb)carry;
+        if (overshot) {  // qhat was one too large: add the divisor back
+            qhat--;
+            carry = 0;
+            for (size_t i = 0; i < bn; i++) {
+                carry += (DLimb)un[i + j] + vn[i];
+                un[i + j] = (Limb)carry;
+                carry >>= LIMB_BITS;
+            }
+            un[j + bn] += (Limb)carry;
+        }
+        q[j] = (Limb)qhat;
+    }
+    for (size_t i = 0; i < bn; i++)
+        r[i] = s ? (un[i] >> s) | (un[i + 1] << (LIMB_BITS - s)) : un[i];
+}
+
+void BigInt::divKnuth(const BigInt& a, const BigInt& b, BigInt& q, BigInt& r) {
+    q.negative = r.negative = false;
+    if (cmpMag(a.mag.data(), a.mag.size(), b.mag.data(), b.mag.size()) < 0) {
+        q.mag.clear();
+        r.mag = a.mag;
+        return;
+    }
+    size_t an = a.mag.size(), bn = b.mag.size();
+    if (bn <= 2) {
+        q.mag.resize(an);
+        r = fromWord(divSmall(q.mag.data(), a.mag.data(), an, b.lowWord()));
+        q.trim();
+        return;
+    }
+    LimbVector quot(an - bn + 1), rem(bn);
+    divMag(quot.data(), rem.data(), a.mag.data(), an, b.mag.data(), bn);
+    r.mag = std::move(rem);
+    r.trim();
+    q.mag = std::move(quot);
+    q.trim();
+}
+
+// ============== Burnikel-Ziegler recursive division ==============
+// C. Burnikel, J. Ziegler, "Fast Recursive Division", MPI-I-98-1-022 (1998).
+// Splits the dividend into n-limb blocks and divides two blocks at a time by the
+// normalized n-limb divisor, so the work is dominated by fast multiplications.
+void BigInt::divBurnikelZiegler(const BigInt& a, const BigInt& b, BigInt& q, BigInt& r) {
+    size_t bn = b.mag.size();
+    size_t m = 1;
+    while (m * BZ_THRESHOLD <= bn) m <<= 1;
+    size_t n = (bn + m - 1) / m * m;  // block size: n / m limbs, halved m times down to the base case
+    size_t sigma = (n - bn) * LIMB_BITS + __builtin_clz(b.mag.back());
+    BigInt bs = b.shiftedLeft(sigma), as = a.shiftedLeft(sigma);
+    size_t t = std::max<size_t>(2, (as.bitLength() + n * LIMB_BITS) / (n * LIMB_BITS));
+
+    LimbVector quot(t * n);
+    BigInt z = as.shiftedRight((t - 2) * n * LIMB_BITS), qi, ri;
+    for (size_t i = t - 1; i--;) {
+        div2n1n(z, bs, n, qi, ri);
+        std::copy(qi.mag.begin(), qi.mag.end(), quot.begin() + i * n);
+        if (i) {
+            size_t lo = std::min((i - 1) * n, as.mag.size()), hi = std::min(i * n, as.mag.size());
+            z = concatLimbs(ri, fromLimbs(as.mag.data() + lo, hi - lo), n);
+        }
+    }
+    q.mag = std::move(quot);
+    q.negative = false;
+    q.trim();
+    r = ri.shiftedRight(sigma);
+}
+
+// a < b * 2^(32n), b has exactly n limbs with its top bit set
+void BigInt::div2n1n(const BigInt& a, const BigInt& b, size_t n, BigInt& q, BigInt& r) {
+    if (n % 2 || n < BZ_THRESHOLD) { divKnuth(a, b, q, r); return; }
+    size_t h = n / 2;
+    BigInt q1, r1;
+    div3n2n(a.shiftedRight(h * LIMB_BITS), b, h, q1, r1);
+    div3n2n(concatLimbs(r1, a.lowLimbs(h), h), b, h, q, r);
+    q = concatLimbs(q1, q, h);
+}
+
+// a < b * 2^(32n), b has exactly 2n limbs with its top bit set
+void BigInt::div3n2n(const BigInt& a, const BigInt& b, size_t n, BigInt& q, BigInt& r) {
+    BigInt a12 = a.shiftedRight(n * LIMB_BITS), b1 = b.shiftedRight(n * LIMB_BITS);
+    BigInt r1;
+    if (a12.shiftedRight(n * LIMB_BITS) < b1) {
+        div2n1n(a12, b1, n, q, r1);
+    } else {  // quotient estimate saturates at 2^(32n) - 1
+        q = BigInt(1).shiftedLeft(n * LIMB_BITS) - BigInt(1);
+        r1 = a12 - b1.shiftedLeft(n * LIMB_BITS) + b1;
+    }
+    r = concatLimbs(r1, a.lowLimbs(n), n) - q * b.lowLimbs(n);
+    while (r.negative) {
+        q = q - BigInt(1);
+        r = r + b;
+    }
+}
@@ -0,0 +1,233 @@
+#include "BigInt.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <stdexcept>
+
+// Odd moduli up to this many limbs use Montgomery products in powMod; past it (measured)
+// a subquadratic product plus a division beats the quadratic CIOS loop
+static constexpr size_t MONTGOMERY_MAX_LIMBS = 256;
+// Leading bits of the operands that a Lehmer step simulates in single precision; 62 keeps
+// every cofactor and every sum in Knuth's algorithm L within an int64_t
+static constexpr int LEHMER_BITS = 62;
+
+// ============== Powers ==============
+BigInt BigInt::abs() const {
+    BigInt r = *this;
+    r.negative = false;
+    return r;
+}
+
+BigInt BigInt::pow(unsigned long long e) const {
+    if (e == 0) return BigInt(1);
+    BigInt r;
+    size_t bits = bitLength();
+    if (bits && mag.back() == Limb(1) << ((bits - 1) % LIMB_BITS) &&
+        std::all_of(mag.begin(), mag.end() - 1, [](Limb x) { return x == 0; })) {
+        r = fromWord(1).shiftedLeft((bits - 1) * e);  // a power of two: just shift
+    } else {
+        // Left to right, so every multiply is by the (short) base
+        r = *this;
+        r.negative = false;
+        for (int i = 62 - __builtin_clzll(e); i >= 0; i--) {
+            r *= r;
+            if (e >> i & 1) r *= abs();
+        }
+    }
+    r.negative = negative && (e & 1) && !r.isZero();
+    return r;
+}
+
+// Window width for sliding-window exponentiation, by exponent size (same cut points as
+// the usual OpenSSL table)
+static int windowBits(size_t bits) {
+    return bits > 671 ? 6 : bits > 239 ? 5 : bits > 79 ? 4 : bits > 23 ? 3 : 1;
+}
+
+// x^e for e > 0 given as limbs, left to right over windows of up to k bits that end in a 1.
+// mul(a, b) returns the reduced product; the odd powers x, x^3, x^5, ... are precomputed.
+template <class T, class Mul>
+static T slidingWindowPow(const T& x, const uint32_t* e, size_t en, Mul mul) {
+    size_t bits = en * 32 - __builtin_clz(e[en - 1]);
+    size_t k = windowBits(bits);
+    auto bit = [e](size_t i) { return e[i / 32] >> (i % 32) & 1; };
+    std::vector<T> odd(size_t(1) << (k - 1));
+    odd[0] = x;
+    if (odd.size() > 1) {
+        T x2 = mul(x, x);
+        for (size_t i = 1; i < odd.size(); i++) odd[i] = mul(odd[i - 1], x2);
+    }
+    T r{};
+    bool started = false;
+    for (size_t i = bits; i-- > 0;) {
+        if (!bit(i)) { r = mul(r, r); continue; }  // the top bit is set, so r has started here
+        size_t j = i + 1 >= k ? i + 1 - k : 0;
+        while (!bit(j)) j++;
+        size_t w = 0;
+        for (size_t t = i + 1; t-- > j;) w = w * 2 + bit(t);
+        if (started) {
+            for (size_t t = j; t <= i; t++) r = mul(r, r);
+            r = mul(r, odd[w / 2]);
+        } else {
+            r = odd[w / 2];
+            started = true;
+        }
+        i = j;
+    }
+    return r;
+}
+
+void BigInt::montMul(Limb* r, const Limb* a, const Limb* b, const Limb* m, size_t n, Limb minv, Limb* t) {
+    std::fill(t, t + n + 2, 0);
+    for (size_t i = 0; i < n; i++) {
+        DLimb c = 0, ai = a[i];
+        for (size_t j = 0; j < n; j++) {
+            c += ai * b[j] + t[j];
+            t[j] = (Limb)c;
+            c >>= LIMB_BITS;
+        }
+        c += t[n];
+        t[n] = (Limb)c;
+        t[n + 1] = (Limb)(c >> LIMB_BITS);
+        // add u * m, which clears the low limb, and shift down by one limb
+        DLimb u = (Limb)(t[0] * minv);
+        c = (u * m[0] + t[0]) >> LIMB_BITS;
+        for (size_t j = 1; j < n; j++) {
+            c += u * m[j] + t[j];
+            t[j - 1] = (Limb)c;
+            c >>= LIMB_BITS;
+        }
+        c += t[n];
+        t[n - 1] = (Limb)c;
+        t[n] = t[n + 1] + (Limb)(c >> LIMB_BITS);
+    }
+    // t < 2m
+    if (t[n] || cmpMag(t, n, m, n) >= 0) subMag(r, t, n, m, n);
+    else std::copy(t, t + n, r);
+}
+
+BigInt BigInt::powModMontgomery(const BigInt& base, const BigInt& e, const BigInt& m) {
+    size_t n = m.mag.size();
+    const Limb* mp = m.mag.data();
+    Limb inv = mp[0];  // correct to 3 bits for odd m; each step doubles that
+    for (int i = 0; i < 4; i++) inv *= 2 - mp[0] * inv;
+    Limb minv = 0 - inv;
+
+    LimbVector scratch(n + 2);
+    Limb* t = scratch.data();
+    auto mul = [&](const LimbVector& a, const LimbVector& b) {
+        LimbVector r(n);
+        montMul(r.data(), a.data(), b.data(), mp, n, minv, t);
+        return r;
+    };
+    LimbVector x = (base.shiftedLeft(n * LIMB_BITS) % m).mag;  // to Montgomery form
+    x.resize(n, 0);
+    LimbVector y = slidingWindowPow(x, e.mag.data(), e.mag.size(), mul);
+    LimbVector one(n);
+    one[0] = 1;
+    BigInt r;
+    r.mag = mul(y, one);  // back out of Montgomery form
+    r.trim();
+    return r;
+}
+
+BigInt BigInt::powMod(const BigInt& base, const BigInt& e, const BigInt& m) {
+    if (m.isZero()) throw std::runtime_error("pow() 3rd argument cannot be 0");
+    if (e.negative) throw std::runtime_error("pow() 2nd argument cannot be negative when 3rd argument specified");
+    BigInt am = m.abs(), b = base % am, r;
+    if (e.isZero()) {
+        r = BigInt(1) % am;
+    } else if (b.isZero()) {
+        r = b;
+    } else if (am.mag.size() <= 2) {
+        DLimb d = am.lowWord();
+        auto mul = [d](DLimb x, DLimb y) { return (DLimb)((unsigned __int128)x * y % d); };
+        r = fromWord(slidingWindowPow(b.lowWord(), e.mag.data(), e.mag.size(), mul));
+    } else if ((am.mag[0] & 1) && am.mag.size() <= MONTGOMERY_MAX_LIMBS) {
+        r = powModMontgomery(b, e, am);
+    } else {
+        auto mul = [&am](const BigInt& x, const BigInt& y) { return x * y % am; };
+        r = slidingWindowPow(b, e.mag.data(), e.mag.size(), mul);
+    }
+    if (m.negative && !r.isZero()) r += m;
+    return r;
+}
+
+// ============== GCD ==============
+// (x >> shift) mod 2^64 for an n-limb x
+static uint64_t bitsAt(const uint32_t* x, size_t n, size_t shift) {
+    size_t i = shift / 32;
+    int s = shift % 32;
+    unsigned __int128 w = 0;
+    for (size_t k = 0; k < 3 && i + k < n; k++) w |= (unsigned __int128)x[i + k] << (32 * k);
+    return (uint64_t)(w >> s);
+}
+
+// (x, y) = (a x + b y, c x + d y) over n limbs; both results are known to be nonnegative
+static void lehmerUpdate(uint32_t* x, uint32_t* y, size_t n, int64_t a, int64_t b, int64_t c, int64_t d) {
+    __int128 cx = 0, cy = 0;
+    for (size_t i = 0; i < n; i++) {
+        cx += (__int128)a * x[i] + (__int128)b * y[i];
+        cy += (__int128)c * x[i] + (__int128)d * y[i];
+        x[i] = (uint32_t)cx;
+        y[i] = (uint32_t)cy;
+        cx >>= 32;
+        cy >>= 32;
+    }
+}
+
+// Lehmer's algorithm (Knuth 4.5.2 L): run Euclid on the leading bits in single precision
+// while the quotients provably match the full ones, then apply the collected cofactors
+// to the full numbers in one pass. Falls back to a full division step when no quotient
+// could be determined.
+BigInt BigInt::gcd(const BigInt& a, const BigInt& b) {
+    BigInt x = a.abs(), y = b.abs();
+    if (x < y) std::swap(x, y);
+    while (y.mag.size() > 2) {
+        size_t shift = x.bitLength() - LEHMER_BITS;
+        int64_t xh = (int64_t)bitsAt(x.mag.data(), x.mag.size(), shift);
+        int64_t yh = (int64_t)bitsAt(y.mag.data(), y.mag.size(), shift);
+        int64_t A = 1, B = 0, C = 0, D = 1;
+        while (yh + C != 0 && yh + D != 0) {
+            int64_t q = (xh + A) / (yh + C);
+            if (q != (xh + B) / (yh + D)) break;
+            int64_t t = A - q * C; A = C; C = t;
+            t = B - q * D; B = D; D = t;
+            t = xh - q * yh; xh = yh; yh = t;
+        }
+        if (B == 0) {
+            x = x % y;
+            std::swap(x, y);
+        } else {
+            y.mag.resize(x.mag.size(), 0);
+            lehmerUpdate(x.mag.data(), y.mag.data(), x.mag.size(), A, B, C, D);
+            x.trim();
+            y.trim();
+        }
+    }
+    if (y.isZero()) return x;
+    DLimb yw = y.lowWord(), xw = divSmall(nullptr, x.mag.data(), x.mag.size(), yw);
+    return fromWord(std::gcd(xw, yw));
+}
+
+// ============== Integer square root ==============
+BigInt BigInt::isqrt() const {
+    if (negative) throw std::runtime_error("isqrt() argument must be nonnegative");
+    if (mag.size() <= 2) {
+        DLimb n = lowWord(), r = (DLimb)std::sqrt((double)n);
+        while ((unsigned __int128)r * r > n) r--;
+        while ((unsigned __int128)(r + 1) * (r + 1) <= n) r++;
+        return fromWord(r);
+    }
+    // Newton's iteration with the precision doubling each round: after the round for d,
+    // a is within one of the root of this >> 2(c - d)
+    size_t c = (bitLength() - 1) / 2, d = 0;
+    BigInt a(1);
+    for (int s = 63 - __builtin_clzll(c); s >= 0; s--) {
+        size_t e = d;
+        d = c >> s;
+        a = a.shiftedLeft(d - e - 1) + shiftedRight(2 * c - e - d + 1) / a;
+    }
+    if (a * a > *this) a -= BigInt(1);
+    return a;
+}
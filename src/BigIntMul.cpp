@@ -0,0 +1,256 @@
+#include "BigInt.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <memory>
+#include <mutex>
+
+// Operand sizes (in limbs of the shorter factor) at which each algorithm starts to win;
+// measured by timing balanced products of random operands around each crossover.
+static constexpr size_t KARATSUBA_THRESHOLD = 16;
+static constexpr size_t TOOM3_THRESHOLD = 1024;
+static constexpr size_t NTT_THRESHOLD = 12288;
+// Longest convolution the three NTT primes support; it also keeps every coefficient
+// (at most 2^22 products of two 32-bit limbs) below p1 * p2 * p3 > 2^86.
+static constexpr size_t NTT_MAX_LEN = size_t(1) << 23;
+// Shorter factor (in limbs) from which the Toom-3 products are forked onto the thread pool,
+// when one is running; NTT products are all larger and always fork their transforms
+static constexpr size_t PARALLEL_THRESHOLD = 4096;
+
+void BigInt::mulMag(Limb* r, const Limb* a, size_t an, const Limb* b, size_t bn) {
+    if (an < bn) { std::swap(a, b); std::swap(an, bn); }
+    if (bn == 0) { std::fill(r, r + an, 0); return; }
+    if (bn < KARATSUBA_THRESHOLD) mulSchool(r, a, an, b, bn);
+    else if (bn >= NTT_THRESHOLD && an + bn <= NTT_MAX_LEN) mulNtt(r, a, an, b, bn);
+    else if (an >= 2 * bn) mulUnbalanced(r, a, an, b, bn);
+    else if (bn < TOOM3_THRESHOLD) mulKaratsuba(r, a, an, b, bn);
+    else mulToom3(r, a, an, b, bn);
+}
+
+void BigInt::mulSchool(Limb* r, const Limb* a, size_t an, const Limb* b, size_t bn) {
+    std::fill(r, r + an + bn, 0);
+    for (size_t i = 0; i < an; i++) {
+        DLimb carry = 0, ai = a[i];
+        for (size_t j = 0; j < bn; j++) {
+            carry += ai * b[j] + r[i + j];
+            r[i + j] = (Limb)carry;
+            carry >>= LIMB_BITS;
+        }
+        r[i + bn] = (Limb)carry;
+    }
+}
+
+// a is much longer than b: multiply bn-limb slices of a by b and accumulate
+void BigInt::mulUnbalanced(Limb* r, const Limb* a, size_t an, const Limb* b, size_t bn) {
+    std::fill(r, r + an + bn, 0);
+    LimbVector part(2 * bn);
+    for (size_t off = 0; off < an; off += bn) {
+        size_t len = std::min(bn, an - off);
+        mulMag(part.data(), a + off, len, b, bn);
+        addMag(r + off, r + off, an + bn - off, part.data(), len + bn);
+    }
+}
+
+// (a1 B^h + a0)(b1 B^h + b0) = z2 B^2h + ((a0 + a1)(b0 + b1) - z2 - z0) B^h + z0
+void BigInt::mulKaratsuba(Limb* r, const Limb* a, size_t an, const Limb* b, size_t bn) {
+    size_t h = (an + 1) / 2;  // an < 2 * bn guarantees bn >= h
+    const Limb *a1 = a + h, *b1 = b + h;
+    size_t a1n = an - h, b1n = bn - h, n = an + bn;
+    mulMag(r, a, h, b, h);
+    mulMag(r + 2 * h, a1, a1n, b1, b1n);
+
+    std::vector<Limb> sa(h + 1), sb(h + 1), mid(2 * h + 2);
+    sa[h] = addMag(sa.data(), a, h, a1, a1n);
+    sb[h] = addMag(sb.data(), b, h, b1, b1n);
+    mulMag(mid.data(), sa.data(), h + 1, sb.data(), h + 1);
+    subMag(mid.data(), mid.data(), mid.size(), r, 2 * h);
+    subMag(mid.data(), mid.data(), mid.size(), r + 2 * h, n - 2 * h);
+    size_t midn = mid.size();
+    while (midn && mid[midn - 1] == 0) midn--;
+    addMag(r + h, r + h, n - h, mid.data(), midn);
+}
+
+// Toom-Cook 3 with Bodrato's evaluation points 0, 1, -1, -2, inf. Evaluation and
+// interpolation go through signed BigInt temporaries; this only runs on large operands
+// where the five recursive products dominate.
+void BigInt::mulToom3(Limb* r, const Limb* a, size_t an, const Limb* b, size_t bn) {
+    size_t k = (an + 2) / 3;
+    auto piece = [k](const Limb* p, size_t n, size_t i) {
+        size_t lo = std::min(n, i * k), hi = std::min(n, (i + 1) * k);
+        return fromLimbs(p + lo, hi - lo);
+    };
+    BigInt a0 = piece(a, an, 0), a1 = piece(a, an, 1), a2 = piece(a, an, 2);
+    BigInt b0 = piece(b, bn, 0), b1 = piece(b, bn, 1), b2 = piece(b, bn, 2);
+
+    BigInt pa = a0 + a2, pb = b0 + b2;
+    BigInt pa1 = pa + a1, pb1 = pb + b1;
+    BigInt pam1 = pa - a1, pbm1 = pb - b1;
+    BigInt pam2 = pam1 + a2, pbm2 = pbm1 + b2;
+    pam2 = pam2 + pam2 - a0;
+    pbm2 = pbm2 + pbm2 - b0;
+
+    BigInt r0, r1, rm1, rm2, rinf;
+    ThreadPool::invoke({[&] { r0 = a0 * b0; }, [&] { r1 = pa1 * pb1; }, [&] { rm1 = pam1 * pbm1; },
+                        [&] { rm2 = pam2 * pbm2; }, [&] { rinf = a2 * b2; }},
+                       bn >= PARALLEL_THRESHOLD);
+
+    BigInt c3 = (rm2 - r1) / BigInt(3);
+    BigInt c1 = (r1 - rm1) / BigInt(2);
+    BigInt c2 = rm1 - r0;
+    c3 = (c2 - c3) / BigInt(2) + rinf + rinf;
+    c2 = c2 + c1 - rinf;
+    c1 = c1 - c3;
+
+    size_t n = an + bn;
+    std::fill(r, r + n, 0);
+    const BigInt* coef[5] = {&r0, &c1, &c2, &c3, &rinf};
+    for (size_t i = 0; i < 5; i++) {
+        const LimbVector& c = coef[i]->mag;
+        if (!c.empty()) addMag(r + i * k, r + i * k, n - i * k, c.data(), c.size());
+    }
+}
+
+// ============== Number-theoretic transform ==============
+// Exact convolution modulo three NTT-friendly primes (all with primitive root 3),
+// recombined with Garner's CRT, so no floating-point rounding is involved.
+static constexpr uint32_t NTT_P1 = 998244353, NTT_P2 = 167772161, NTT_P3 = 469762049;
+
+static constexpr uint32_t powModPrime(uint64_t b, uint64_t e, uint32_t p) {
+    uint64_t r = 1;
+    for (b %= p; e; e >>= 1, b = b * b % p)
+        if (e & 1) r = r * b % p;
+    return (uint32_t)r;
+}
+
+// Montgomery arithmetic modulo P with R = 2^32: mul(a, b) = a * b / R mod P
+template <uint32_t P>
+struct MontMod {
+    static constexpr uint32_t negInv() {
+        uint32_t x = P;  // Newton iteration for P^-1 mod 2^32
+        for (int i = 0; i < 4; i++) x *= 2 - P * x;
+        return 0u - x;
+    }
+    static constexpr uint32_t NEG_INV = negInv();
+    static constexpr uint32_t R_MOD = (uint32_t)(((uint64_t)1 << 32) % P);
+    static constexpr uint32_t R2_MOD = (uint32_t)((uint64_t)R_MOD * R_MOD % P);
+
+    static uint32_t mul(uint32_t a, uint32_t b) {
+        uint64_t t = (uint64_t)a * b;
+        uint32_t m = (uint32_t)t * NEG_INV;
+        uint32_t u = (uint32_t)((t + (uint64_t)m * P) >> 32);
+        return u >= P ? u - P : u;
+    }
+    static uint32_t toMont(uint32_t a) { return mul(a, R2_MOD); }
+};
+
+using TwiddleTable = std::shared_ptr<const std::vector<uint32_t>>;
+
+// Twiddles for every butterfly span, in Montgomery form: tw[len + j] = w_{2len}^j.
+// The layout does not depend on the transform size, so one table per direction is
+// grown on demand and shared by all transforms. Growing publishes a new table, so
+// transforms running on other threads keep the one they hold.
+template <uint32_t P>
+static TwiddleTable nttTwiddles(size_t n, bool inverse) {
+    using M = MontMod<P>;
+    static std::mutex lock;
+    static TwiddleTable tables[2];
+    std::lock_guard<std::mutex> lk(lock);
+    TwiddleTable& cur = tables[inverse];
+    if (cur && cur->size() >= n) return cur;
+    auto tw = cur ? std::make_shared<std::vector<uint32_t>>(*cur) : std::make_shared<std::vector<uint32_t>>();
+    size_t len = std::max<size_t>(tw->size(), 1);
+    tw->resize(n);
+    for (; len < n; len <<= 1) {
+        uint32_t root = powModPrime(3, (P - 1) / (2 * len), P);
+        if (inverse) root = powModPrime(root, P - 2, P);
+        uint32_t step = M::toMont(root);
+        (*tw)[len] = M::R_MOD;
+        for (size_t j = 1; j < len; j++) (*tw)[len + j] = M::mul((*tw)[len + j - 1], step);
+    }
+    cur = tw;
+    return cur;
+}
+
+// Forward transform: decimation in frequency, natural order in, bit-reversed order out
+template <uint32_t P>
+static void nttForward(uint32_t* a, size_t n, const std::vector<uint32_t>& tw) {
+    using M = MontMod<P>;
+    for (size_t len = n / 2; len; len >>= 1) {
+        const uint32_t* w = tw.data() + len;
+        for (size_t i = 0; i < n; i += 2 * len) {
+            for (size_t j = 0; j < len; j++) {
+                uint32_t u = a[i + j], v = a[i + j + len];
+                a[i + j] = u + v >= P ? u + v - P : u + v;
+                a[i + j + len] = M::mul(u + P - v, w[j]);
+            }
+        }
+    }
+}
+
+// Inverse transform: decimation in time, bit-reversed order in, natural order out (unscaled)
+template <uint32_t P>
+static void nttInverse(uint32_t* a, size_t n, const std::vector<uint32_t>& tw) {
+    using M = MontMod<P>;
+    for (size_t len = 1; len < n; len <<= 1) {
+        const uint32_t* w = tw.data() + len;
+        for (size_t i = 0; i < n; i += 2 * len) {
+            for (size_t j = 0; j < len; j++) {
+                uint32_t u = a[i + j], v = M::mul(a[i + j + len], w[j]);
+                a[i + j] = u + v >= P ? u + v - P : u + v;
+                a[i + j + len] = u >= v ? u - v : u + P - v;
+            }
+        }
+    }
+}
+
+// Cyclic convolution of a and b modulo P into res (n entries, n a power of two).
+// Values stay in normal form; the single 1/R from the pointwise Montgomery product
+// is folded into the final 1/n scaling.
+template <uint32_t P>
+static void nttConvolve(LimbVector& res, const uint32_t* a, size_t an,
+                        const uint32_t* b, size_t bn, size_t n, bool square) {
+    using M = MontMod<P>;
+    res.assign(n, 0);
+    uint32_t* fa = res.data();
+    for (size_t i = 0; i < an; i++) fa[i] = a[i] % P;
+    TwiddleTable fwd = nttTwiddles<P>(n, false);
+    if (square) {
+        nttForward<P>(fa, n, *fwd);
+        for (size_t i = 0; i < n; i++) fa[i] = M::mul(fa[i], fa[i]);
+    } else {
+        LimbVector tmp(n);
+        uint32_t* fb = tmp.data();
+        for (size_t i = 0; i < bn; i++) fb[i] = b[i] % P;
+        ThreadPool::invoke({[&] { nttForward<P>(fa, n, *fwd); }, [&] { nttForward<P>(fb, n, *fwd); }});
+        for (size_t i = 0; i < n; i++) fa[i] = M::mul(fa[i], fb[i]);
+    }
+    nttInverse<P>(fa, n, *nttTwiddles<P>(n, true));
+    // scale by R^2 / n in Montgomery form: mul(x, R^2 / n) = x * R / n
+    uint32_t scale = (uint32_t)((uint64_t)M::R2_MOD * powModPrime(n, P - 2, P) % P);
+    for (size_t i = 0; i < n; i++) fa[i] = M::mul(fa[i], scale);
+}
+
+void BigInt::mulNtt(Limb* r, const Limb* a, size_t an, const Limb* b, size_t bn) {
+    size_t n = 1;
+    while (n < an + bn) n <<= 1;
+    bool square = (a == b && an == bn);
+    LimbVector t1, t2, t3;
+    ThreadPool::invoke({[&] { nttConvolve<NTT_P1>(t1, a, an, b, bn, n, square); },
+                        [&] { nttConvolve<NTT_P2>(t2, a, an, b, bn, n, square); },
+                        [&] { nttConvolve<NTT_P3>(t3, a, an, b, bn, n, square); }});
+    const uint32_t *c1 = t1.data(), *c2 = t2.data(), *c3 = t3.data();
+
+    // Garner: x = x1 + p1 * k2 + p1 * p2 * k3 with k2 < p2, k3 < p3
+    constexpr uint64_t inv1mod2 = powModPrime(NTT_P1, NTT_P2 - 2, NTT_P2);
+    constexpr uint64_t p12mod3 = (uint64_t)NTT_P1 * NTT_P2 % NTT_P3;
+    constexpr uint64_t inv12mod3 = powModPrime(p12mod3, NTT_P3 - 2, NTT_P3);
+    unsigned __int128 carry = 0;
+    for (size_t i = 0; i < an + bn; i++) {
+        uint64_t x1 = c1[i];
+        uint64_t k2 = (c2[i] + NTT_P2 - x1 % NTT_P2) % NTT_P2 * inv1mod2 % NTT_P2;
+        uint64_t x12 = x1 + (uint64_t)NTT_P1 * k2;
+        uint64_t k3 = (c3[i] + NTT_P3 - x12 % NTT_P3) % NTT_P3 * inv12mod3 % NTT_P3;
+        carry += x12 + (unsigned __int128)((uint64_t)NTT_P1 * NTT_P2) * k3;
+        r[i] = (Limb)carry;
+        carry >>= LIMB_BITS;
+    }
+}
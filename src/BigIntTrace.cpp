@@ -0,0 +1,38 @@
+#include "BigIntTrace.h"
+#include <cstdlib>
+
+FILE* BigIntTrace::out = nullptr;
+bool BigIntTrace::values = false;
+
+// Traces of long runs are large; write them in big blocks
+static constexpr size_t TRACE_BUFFER_BYTES = size_t(1) << 20;
+
+bool BigIntTrace::start(const std::string& path, bool withValues) {
+    FILE* f = std::fopen(path.c_str(), "w");
+    if (!f) return false;
+    std::setvbuf(f, nullptr, _IOFBF, TRACE_BUFFER_BYTES);
+    std::fprintf(f, "%s\n", HEADER);
+    out = f;
+    values = withValues;
+    std::atexit(finish);
+    return true;
+}
+
+void BigIntTrace::write(const char* op, std::initializer_list<const BigInt*> operands, const long long* word) {
+    std::fputs(op, out);
+    for (const BigInt* x : operands) {
+        if (values) {
+            std::fputs(" V", out);
+            std::fputs(x->toString().c_str(), out);
+        } else {
+            std::fprintf(out, " %sL%zu", x->isNegative() ? "-" : "", x->limbCount());
+        }
+    }
+    if (word) std::fprintf(out, " E%lld", *word);
+    std::fputc('\n', out);
+}
+
+void BigIntTrace::finish() {
+    std::fclose(out);
+    out = nullptr;
+}
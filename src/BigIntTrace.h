@@ -0,0 +1,42 @@
+#pragma once
+#ifndef PYTHON_INTERPRETER_BIGINTTRACE_H
+#define PYTHON_INTERPRETER_BIGINTTRACE_H
+
+#include "BigInt.h"
+#include <cstdio>
+#include <initializer_list>
+#include <string>
+
+// Log of the BigInt operations the interpreter performs (--trace-bigint=FILE), for
+// replaying a script's arithmetic without the front end (tools/bigint_replay.cpp).
+//
+// The file starts with the line "# bigint-trace 1", then holds one operation per line:
+// the operation name followed by its operands. An operand is written as L<limbs> (-L<limbs>
+// when negative), or as V<decimal value> when values are traced; E<n> is a machine-word
+// argument such as a pow exponent.
+//
+//   add L12 -L3
+//   pow V7 E1000
+class BigIntTrace {
+public:
+    static constexpr const char* HEADER = "# bigint-trace 1";
+
+    static bool start(const std::string& path, bool values);  // false if the file cannot be opened
+    static bool active() { return out != nullptr; }
+
+    static void record(const char* op, std::initializer_list<const BigInt*> operands) {
+        if (out) write(op, operands, nullptr);
+    }
+    static void record(const char* op, std::initializer_list<const BigInt*> operands, long long word) {
+        if (out) write(op, operands, &word);
+    }
+
+private:
+    static FILE* out;
+    static bool values;
+
+    static void write(const char* op, std::initializer_list<const BigInt*> operands, const long long* word);
+    static void finish();
+};
+
+#endif
@@ -1,207 +1,275 @@
 #include "Evalvisitor.h"
+#include "BigIntTrace.h"
 #include "Python3Lexer.h"
 #include "Python3Parser.h"
 #include <iostream>
 #include <cmath>
 #include <algorithm>
 #include <cctype>
+#include <climits>
+#include <numeric>
+#include <exception>
+#include <pthread.h>
 
-// ============== BigInt ==============
-std::string BigInt::trimZeros(std::string s) {
-    size_t i = 0;
-    while (i < s.size() && s[i] == '0') i++;
-    return i < s.size() ? s.substr(i) : "0";
+// ============== Integer helpers ==============
+// Ints are kept as long long while they fit and promoted to BigInt on overflow;
+// results are normalized back, so a BigInt Value is always outside the long long range.
+static bool isInt(const Value& v) {
+    return std::holds_alternative<long long>(v) || std::holds_alternative<BigInt>(v);
+}
+
+static const BigInt& asBigInt(const Value& v, BigInt& tmp) {
+    if (std::holds_alternative<BigInt>(v)) return std::get<BigInt>(v);
+    long long x = std::get<long long>(v);
+    if (const BigInt* c = BigInt::cached(x)) return *c;
+    tmp = BigInt(x);
+    return tmp;
 }
 
-int BigInt::compare(const std::string& a, const std::string& b) {
-    if (a.size() != b.size()) return a.size() < b.size() ? -1 : 1;
-    for (size_t i = 0; i < a.size(); i++) {
-        if (a[i] != b[i]) return a[i] < b[i] ? -1 : 1;
+static Value normalizeInt(BigInt&& b) {
+    if (b.fitsLong()) return b.toLong();
+    return std::move(b);
+}
+
+static Value intAdd(const Value& a, const Value& b) {
+    if (std::holds_alternative<long long>(a) && std::holds_alternative<long long>(b)) {
+        long long r;
+        if (!__builtin_add_overflow(std::get<long long>(a), std::get<long long>(b), &r)) return r;
     }
-    return 0;
+    BigInt ta, tb;
+    const BigInt &x = asBigInt(a, ta), &y = asBigInt(b, tb);
+    BigIntTrace::record("add", {&x, &y});
+    return normalizeInt(x + y);
 }
 
-std::string BigInt::add(const std::string& a, const std::string& b) {
-    std::string res;
-    int carry = 0;
-    size_t i = a.size(), j = b.size();
-    while (i || j || carry) {
-        int sum = carry;
-        if (i) sum += a[--i] - '0';
-        if (j) sum += b[--j] - '0';
-        res += char('0' + sum % 10);
-        carry = sum / 10;
+static Value intSub(const Value& a, const Value& b) {
+    if (std::holds_alternative<long long>(a) && std::holds_alternative<long long>(b)) {
+        long long r;
+        if (!__builtin_sub_overflow(std::get<long long>(a), std::get<long long>(b), &r)) return r;
     }
-    std::reverse(res.begin(), res.end());
-    return trimZeros(res);
+    BigInt ta, tb;
+    const BigInt &x = asBigInt(a, ta), &y = asBigInt(b, tb);
+    BigIntTrace::record("sub", {&x, &y});
+    return normalizeInt(x - y);
 }
 
-std::string BigInt::sub(const std::string& a, const std::string& b) {
-    if (compare(a, b) < 0) return "0";
-    std::string res;
-    int borrow = 0;
-    size_t i = a.size(), j = b.size();
-    while (i) {
-        int d = a[--i] - '0' - borrow;
-        if (j) d -= b[--j] - '0';
-        if (d < 0) { d += 10; borrow = 1; } else borrow = 0;
-        res += char('0' + d);
-    }
-    std::reverse(res.begin(), res.end());
-    return trimZeros(res);
-}
-
-std::string BigInt::mul(const std::string& a, const std::string& b) {
-    if (a == "0" || b == "0") return "0";
-    std::vector<int> v(a.size() + b.size(), 0);
-    for (size_t i = 0; i < a.size(); i++)
-        for (size_t j = 0; j < b.size(); j++)
-            v[i + j + 1] += (a[i] - '0') * (b[j] - '0');
-    for (size_t k = v.size() - 1; k; k--) {
-        v[k - 1] += v[k] / 10;
-        v[k] %= 10;
+static Value intMul(const Value& a, const Value& b) {
+    if (std::holds_alternative<long long>(a) && std::holds_alternative<long long>(b)) {
+        long long r;
+        if (!__builtin_mul_overflow(std::get<long long>(a), std::get<long long>(b), &r)) return r;
     }
-    std::string res;
-    for (size_t k = (v[0] == 0 ? 1 : 0); k < v.size(); k++) res += char('0' + v[k]);
-    return res;
-}
-
-std::string BigInt::divmod(const std::string& a, const std::string& b, std::string& rem) {
-    if (b == "0") throw std::runtime_error("division by zero");
-    int cmp = compare(a, b);
-    if (cmp < 0) { rem = a; return "0"; }
-    if (cmp == 0) { rem = "0"; return "1"; }
-    std::string mult[10];
-    for (int d = 0; d <= 9; d++) mult[d] = mul(b, std::string(1, '0' + d));
-    std::string q, r = "";
-    for (size_t i = 0; i < a.size(); i++) {
-        r += a[i];
-        r = trimZeros(r);
-        int d = 0;
-        for (int digit = 9; digit >= 0; digit--) {
-            if (compare(r, mult[digit]) >= 0) {
-                r = sub(r, mult[digit]);
-                d = digit;
-                break;
-            }
+    BigInt ta, tb;
+    const BigInt &x = asBigInt(a, ta), &y = asBigInt(b, tb);
+    BigIntTrace::record("mul", {&x, &y});
+    return normalizeInt(x * y);
+}
+
+// Floor division and modulo: -5 // 3 = -2, -5 % 3 = 1
+static Value intFloorDiv(const Value& a, const Value& b) {
+    if (std::holds_alternative<long long>(a) && std::holds_alternative<long long>(b)) {
+        long long x = std::get<long long>(a), y = std::get<long long>(b);
+        if (y == 0) throw std::runtime_error("division by zero");
+        if (y != -1 || x != LLONG_MIN) {  // LLONG_MIN // -1 overflows
+            long long q = x / y;
+            if (x % y != 0 && ((x < 0) != (y < 0))) q--;
+            return q;
         }
-        q += char('0' + d);
     }
-    rem = trimZeros(r);
-    return trimZeros(q);
+    BigInt ta, tb;
+    const BigInt &x = asBigInt(a, ta), &y = asBigInt(b, tb);
+    BigIntTrace::record("floordiv", {&x, &y});
+    return normalizeInt(x / y);
 }
 
-BigInt::BigInt(long long n) {
-    if (n < 0) { negative = true; n = -n; } else negative = false;
-    if (n == 0) { digits = "0"; return; }
-    digits.clear();
-    while (n) { digits += char('0' + n % 10); n /= 10; }
-    std::reverse(digits.begin(), digits.end());
+static Value intFloorMod(const Value& a, const Value& b) {
+    if (std::holds_alternative<long long>(a) && std::holds_alternative<long long>(b)) {
+        long long x = std::get<long long>(a), y = std::get<long long>(b);
+        if (y == 0) throw std::runtime_error("division by zero");
+        if (y == -1) return 0LL;
+        long long r = x % y;
+        if (r != 0 && ((r < 0) != (y < 0))) r += y;
+        return r;
+    }
+    BigInt ta, tb;
+    const BigInt &x = asBigInt(a, ta), &y = asBigInt(b, tb);
+    BigIntTrace::record("mod", {&x, &y});
+    return normalizeInt(x % y);
 }
 
-BigInt::BigInt(const std::string& s) {
-    std::string t = s;
-    while (!t.empty() && t[0] == ' ') t = t.substr(1);
-    if (t.empty()) { negative = false; digits = "0"; return; }
-    if (t[0] == '-') { negative = true; t = t.substr(1); } else negative = false;
-    if (t[0] == '+') t = t.substr(1);
-    digits = trimZeros(t);
-    if (digits == "0") negative = false;
+// Quotient and remainder from one division
+static std::pair<Value, Value> intDivMod(const Value& a, const Value& b) {
+    if (std::holds_alternative<long long>(a) && std::holds_alternative<long long>(b)) {
+        long long x = std::get<long long>(a), y = std::get<long long>(b);
+        if (y == 0) throw std::runtime_error("division by zero");
+        if (y != -1 || x != LLONG_MIN) {
+            long long q = x / y, r = x % y;
+            if (r != 0 && ((r < 0) != (y < 0))) { q--; r += y; }
+            return {q, r};
+        }
+    }
+    BigInt ta, tb, q, r;
+    const BigInt &x = asBigInt(a, ta), &y = asBigInt(b, tb);
+    BigIntTrace::record("divmod", {&x, &y});
+    BigInt::divMod(x, y, q, r);
+    return {normalizeInt(std::move(q)), normalizeInt(std::move(r))};
 }
 
-std::string BigInt::toString() const {
-    return negative ? "-" + digits : digits;
+static Value intNeg(const Value& a) {
+    if (std::holds_alternative<long long>(a) && std::get<long long>(a) != LLONG_MIN) return -std::get<long long>(a);
+    BigInt ta;
+    const BigInt& x = asBigInt(a, ta);
+    BigIntTrace::record("neg", {&x});
+    return normalizeInt(-x);
 }
 
-long long BigInt::toLong() const {
-    long long r = 0;
-    for (char c : digits) r = r * 10 + (c - '0');
-    return negative ? -r : r;
+// In-place variants for augmented assignment: a BigInt target is updated in its own buffer
+static void intAddInPlace(Value& a, const Value& b) {
+    if (std::holds_alternative<long long>(a)) {
+        long long r;
+        if (std::holds_alternative<long long>(b) && !__builtin_add_overflow(std::get<long long>(a), std::get<long long>(b), &r)) a = r;
+        else a = intAdd(a, b);
+        return;
+    }
+    BigInt& x = std::get<BigInt>(a);
+    BigInt tb;
+    const BigInt& y = asBigInt(b, tb);
+    BigIntTrace::record("iadd", {&x, &y});
+    x += y;
+    if (x.fitsLong()) a = x.toLong();
 }
 
-BigInt BigInt::operator-() const {
-    BigInt r = *this;
-    if (digits != "0") r.negative = !r.negative;
-    return r;
+static void intSubInPlace(Value& a, const Value& b) {
+    if (std::holds_alternative<long long>(a)) {
+        long long r;
+        if (std::holds_alternative<long long>(b) && !__builtin_sub_overflow(std::get<long long>(a), std::get<long long>(b), &r)) a = r;
+        else a = intSub(a, b);
+        return;
+    }
+    BigInt& x = std::get<BigInt>(a);
+    BigInt tb;
+    const BigInt& y = asBigInt(b, tb);
+    BigIntTrace::record("isub", {&x, &y});
+    x -= y;
+    if (x.fitsLong()) a = x.toLong();
 }
 
-BigInt BigInt::operator+(const BigInt& o) const {
-    if (negative == o.negative) {
-        BigInt r; r.negative = negative; r.digits = add(digits, o.digits); return r;
+static void intMulInPlace(Value& a, const Value& b) {
+    if (std::holds_alternative<long long>(a)) {
+        long long r;
+        if (std::holds_alternative<long long>(b) && !__builtin_mul_overflow(std::get<long long>(a), std::get<long long>(b), &r)) a = r;
+        else a = intMul(a, b);
+        return;
     }
-    int c = compare(digits, o.digits);
-    if (c == 0) return BigInt(0);
-    BigInt r;
-    if (c > 0) {
-        r.negative = negative;
-        r.digits = sub(digits, o.digits);
-    } else {
-        r.negative = o.negative;
-        r.digits = sub(o.digits, digits);
-    }
-    return r;
+    BigInt& x = std::get<BigInt>(a);
+    BigInt tb;
+    const BigInt& y = asBigInt(b, tb);
+    BigIntTrace::record("imul", {&x, &y});
+    x *= y;
+    if (x.fitsLong()) a = x.toLong();
 }
 
-BigInt BigInt::operator-(const BigInt& o) const {
-    return *this + (-o);
+// a += x * y, or a -= x * y. Once a BigInt is involved the product is accumulated into
+// a's buffer without materializing it.
+static void intAddMulInPlace(Value& a, const Value& x, const Value& y, bool sub) {
+    if (std::holds_alternative<long long>(a) && std::holds_alternative<long long>(x) && std::holds_alternative<long long>(y)) {
+        Value p = intMul(x, y);
+        if (sub) intSubInPlace(a, p);
+        else intAddInPlace(a, p);
+        return;
+    }
+    if (std::holds_alternative<long long>(a)) a = BigInt(std::get<long long>(a));
+    BigInt& acc = std::get<BigInt>(a);
+    BigInt tx, ty;
+    const BigInt &p = asBigInt(x, tx), &q = asBigInt(y, ty);
+    BigIntTrace::record(sub ? "submul" : "addmul", {&acc, &p, &q});
+    if (sub) acc.subMul(p, q);
+    else acc.addMul(p, q);
+    if (acc.fitsLong()) a = acc.toLong();
 }
 
-BigInt BigInt::operator*(const BigInt& o) const {
-    BigInt r; r.negative = (negative != o.negative); r.digits = mul(digits, o.digits);
-    if (r.digits == "0") r.negative = false;
-    return r;
+// ============== Number theory builtins ==============
+static Value intAbs(const Value& a) {
+    if (std::holds_alternative<long long>(a) && std::get<long long>(a) != LLONG_MIN) {
+        long long x = std::get<long long>(a);
+        return x < 0 ? -x : x;
+    }
+    BigInt ta;
+    const BigInt& x = asBigInt(a, ta);
+    BigIntTrace::record("abs", {&x});
+    return normalizeInt(x.abs());
 }
 
-BigInt BigInt::operator/(const BigInt& o) const {
-    if (o.digits == "0") throw std::runtime_error("division by zero");
-    std::string rem;
-    std::string q = divmod(digits, o.digits, rem);
-    bool neg = (negative != o.negative);
-    if (neg && rem != "0") q = add(q, "1");  // floor division: -5//3 = -2
-    BigInt r; r.negative = neg; r.digits = q;
-    if (r.digits == "0") r.negative = false;
-    return r;
+// a ** e for e >= 0; stays in long long until a square or product overflows
+static Value intPow(const Value& a, unsigned long long e) {
+    if (std::holds_alternative<long long>(a)) {
+        long long b = std::get<long long>(a), r = 1;
+        for (unsigned long long k = e;;) {
+            if ((k & 1) && __builtin_mul_overflow(r, b, &r)) break;
+            if (!(k >>= 1)) return r;
+            if (__builtin_mul_overflow(b, b, &b)) break;
+        }
+    }
+    BigInt ta;
+    const BigInt& x = asBigInt(a, ta);
+    BigIntTrace::record("pow", {&x}, (long long)e);
+    return normalizeInt(x.pow(e));
 }
 
-BigInt BigInt::operator%(const BigInt& o) const {
-    if (o.digits == "0") throw std::runtime_error("division by zero");
-    std::string rem;
-    divmod(digits, o.digits, rem);
-    BigInt r; r.negative = negative; r.digits = rem;
-    if (r.digits == "0") r.negative = false;
-    return r;
+static Value intPowMod(const Value& a, const Value& e, const Value& m) {
+    if (std::holds_alternative<long long>(a) && std::holds_alternative<long long>(e) &&
+        std::holds_alternative<long long>(m) && std::get<long long>(e) >= 0 && std::get<long long>(m) > 0) {
+        unsigned long long k = std::get<long long>(e), d = std::get<long long>(m);
+        long long x = std::get<long long>(a) % (long long)d;
+        unsigned long long b = x < 0 ? x + d : x, r = 1 % d;
+        for (; k; k >>= 1) {
+            if (k & 1) r = (unsigned __int128)r * b % d;
+            b = (unsigned __int128)b * b % d;
+        }
+        return (long long)r;
+    }
+    BigInt ta, te, tm;
+    const BigInt &x = asBigInt(a, ta), &y = asBigInt(e, te), &z = asBigInt(m, tm);
+    BigIntTrace::record("powmod", {&x, &y, &z});
+    return normalizeInt(BigInt::powMod(x, y, z));
 }
 
-bool BigInt::operator<(const BigInt& o) const {
-    if (negative != o.negative) return negative;
-    int c = compare(digits, o.digits);
-    return negative ? c > 0 : c < 0;
+static Value intGcd(const Value& a, const Value& b) {
+    if (std::holds_alternative<long long>(a) && std::holds_alternative<long long>(b)) {
+        long long x = std::get<long long>(a), y = std::get<long long>(b);
+        unsigned long long g = std::gcd(x < 0 ? 0ULL - x : (unsigned long long)x, y < 0 ? 0ULL - y : (unsigned long long)y);
+        if (g <= LLONG_MAX) return (long long)g;
+    }
+    BigInt ta, tb;
+    const BigInt &x = asBigInt(a, ta), &y = asBigInt(b, tb);
+    BigIntTrace::record("gcd", {&x, &y});
+    return normalizeInt(BigInt::gcd(x, y));
 }
-bool BigInt::operator>(const BigInt& o) const { return o < *this; }
-bool BigInt::operator<=(const BigInt& o) const { return !(o < *this); }
-bool BigInt::operator>=(const BigInt& o) const { return !(*this < o); }
-bool BigInt::operator==(const BigInt& o) const { return negative == o.negative && digits == o.digits; }
-bool BigInt::operator!=(const BigInt& o) const { return !(*this == o); }
 
-BigInt& BigInt::operator+=(const BigInt& o) { *this = *this + o; return *this; }
-BigInt& BigInt::operator-=(const BigInt& o) { *this = *this - o; return *this; }
-BigInt& BigInt::operator*=(const BigInt& o) { *this = *this * o; return *this; }
-BigInt& BigInt::operator/=(const BigInt& o) { *this = *this / o; return *this; }
-BigInt& BigInt::operator%=(const BigInt& o) { *this = *this % o; return *this; }
-
-// Floor division and modulo: -5 // 3 = -2, -5 % 3 = 1; a % b = a - (a//b)*b
-static BigInt floorDiv(BigInt a, BigInt b) {
-    return a / b;  // BigInt::operator/ already does floor division
+static Value intIsqrt(const Value& a) {
+    BigInt ta;
+    const BigInt& x = asBigInt(a, ta);
+    BigIntTrace::record("isqrt", {&x});
+    return normalizeInt(x.isqrt());
 }
-static BigInt floorMod(BigInt a, BigInt b) {
-    return a - (a / b) * b;
+
+static int intCompare(const Value& a, const Value& b) {
+    if (std::holds_alternative<long long>(a) && std::holds_alternative<long long>(b)) {
+        long long x = std::get<long long>(a), y = std::get<long long>(b);
+        return x < y ? -1 : (x > y ? 1 : 0);
+    }
+    BigInt ta, tb;
+    const BigInt& x = asBigInt(a, ta);
+    const BigInt& y = asBigInt(b, tb);
+    BigIntTrace::record("compare", {&x, &y});
+    if (x < y) return -1; if (x > y) return 1; return 0;
 }
 
 // ============== Value helpers ==============
 bool EvalVisitor::isTrue(const Value& v) {
     if (std::holds_alternative<PyNone>(v)) return false;
     if (std::holds_alternative<bool>(v)) return std::get<bool>(v);
-    if (std::holds_alternative<BigInt>(v)) return std::get<BigInt>(v) != BigInt(0);
+    if (std::holds_alternative<long long>(v)) return std::get<long long>(v) != 0;
+    if (std::holds_alternative<BigInt>(v)) return !std::get<BigInt>(v).isZero();
     if (std::holds_alternative<double>(v)) return std::get<double>(v) != 0.0;
     if (std::holds_alternative<std::string>(v)) return !std::get<std::string>(v).empty();
     if (std::holds_alternative<std::shared_ptr<PyTuple>>(v)) return !std::get<std::shared_ptr<PyTuple>>(v)->elts.empty();
@@ -215,23 +283,21 @@ std::string EvalVisitor::formatFloat(double d) {
 }
 
 Value EvalVisitor::toInt(const Value& v) {
-    if (std::holds_alternative<BigInt>(v)) return v;
-    if (std::holds_alternative<double>(v)) return BigInt((long long)std::get<double>(v));
-    if (std::holds_alternative<bool>(v)) return BigInt(std::get<bool>(v) ? 1 : 0);
+    if (isInt(v)) return v;
+    if (std::holds_alternative<double>(v)) return (long long)std::get<double>(v);
+    if (std::holds_alternative<bool>(v)) return std::get<bool>(v) ? 1LL : 0LL;
     if (std::holds_alternative<std::string>(v)) {
-        const std::string& s = std::get<std::string>(v);
-        if (s.empty()) throw std::runtime_error("invalid literal for int()");
-        size_t i = 0;
-        if (s[i] == '+' || s[i] == '-') i++;
-        for (; i < s.size(); i++) if (!std::isdigit((unsigned char)s[i])) throw std::runtime_error("invalid literal for int()");
-        return BigInt(s);
+        BigInt x(std::get<std::string>(v));  // validates while converting
+        BigIntTrace::record("parse", {&x});
+        return normalizeInt(std::move(x));
     }
     throw std::runtime_error("cannot convert to int");
 }
 
 Value EvalVisitor::toFloat(const Value& v) {
     if (std::holds_alternative<double>(v)) return v;
-    if (std::holds_alternative<BigInt>(v)) return (double)std::get<BigInt>(v).toLong();
+    if (std::holds_alternative<long long>(v)) return (double)std::get<long long>(v);
+    if (std::holds_alternative<BigInt>(v)) return std::get<BigInt>(v).toDouble();
     if (std::holds_alternative<bool>(v)) return std::get<bool>(v) ? 1.0 : 0.0;
     if (std::holds_alternative<std::string>(v)) return std::stod(std::get<std::string>(v));
     throw std::runtime_error("cannot convert to float");
@@ -239,10 +305,24 @@ Value EvalVisitor::toFloat(const Value& v) {
 
 Value EvalVisitor::toStr(const Value& v) {
     if (std::holds_alternative<std::string>(v)) return v;
-    if (std::holds_alternative<BigInt>(v)) return std::get<BigInt>(v).toString();
+    if (std::holds_alternative<long long>(v)) return std::to_string(std::get<long long>(v));
+    if (std::holds_alternative<BigInt>(v)) {
+        BigIntTrace::record("str", {&std::get<BigInt>(v)});
+        return std::get<BigInt>(v).toString();
+    }
     if (std::holds_alternative<double>(v)) return formatFloat(std::get<double>(v));
     if (std::holds_alternative<bool>(v)) return std::get<bool>(v) ? "True" : "False";
     if (std::holds_alternative<PyNone>(v)) return "None";
+    if (std::holds_alternative<std::shared_ptr<PyTuple>>(v)) {
+        const auto& elts = std::get<std::shared_ptr<PyTuple>>(v)->elts;
+        std::string s = "(";
+        for (size_t i = 0; i < elts.size(); i++) {
+            if (i) s += ", ";
+            if (std::holds_alternative<std::string>(elts[i])) s += "'" + std::get<std::string>(elts[i]) + "'";
+            else s += std::get<std::string>(toStr(elts[i]));
+        }
+        return s + (elts.size() == 1 ? ",)" : ")");
+    }
     return "?";
 }
 
@@ -251,10 +331,7 @@ Value EvalVisitor::toBool(const Value& v) {
 }
 
 int EvalVisitor::compareValues(const Value& a, const Value& b) {
-    if (std::holds_alternative<BigInt>(a) && std::holds_alternative<BigInt>(b)) {
-        BigInt x = std::get<BigInt>(a), y = std::get<BigInt>(b);
-        if (x < y) return -1; if (x > y) return 1; return 0;
-    }
+    if (isInt(a) && isInt(b)) return intCompare(a, b);
     if (std::holds_alternative<double>(a) && std::holds_alternative<double>(b)) {
         double x = std::get<double>(a), y = std::get<double>(b);
         if (x < y) return -1; if (x > y) return 1; return 0;
@@ -269,13 +346,13 @@ Value EvalVisitor::tryConvertForCompare(const Value& a, const Value& b) {
     if (std::holds_alternative<PyNone>(a) || std::holds_alternative<PyNone>(b)) return PyNone{};
     if (std::holds_alternative<std::string>(a) || std::holds_alternative<std::string>(b)) return PyNone{};
     try {
-        if (std::holds_alternative<BigInt>(a) && std::holds_alternative<double>(b))
+        if (isInt(a) && std::holds_alternative<double>(b))
             return compareValues(a, toInt(b)) == 0;
-        if (std::holds_alternative<double>(a) && std::holds_alternative<BigInt>(b))
+        if (std::holds_alternative<double>(a) && isInt(b))
             return compareValues(toInt(a), b) == 0;
-        if (std::holds_alternative<BigInt>(a) && std::holds_alternative<bool>(b))
+        if (isInt(a) && std::holds_alternative<bool>(b))
             return compareValues(a, toInt(b)) == 0;
-        if (std::holds_alternative<bool>(a) && std::holds_alternative<BigInt>(b))
+        if (std::holds_alternative<bool>(a) && isInt(b))
             return compareValues(toInt(a), b) == 0;
         if (std::holds_alternative<double>(a) && std::holds_alternative<bool>(b))
             return compareValues(a, toFloat(b)) == 0;
@@ -287,47 +364,178 @@ Value EvalVisitor::tryConvertForCompare(const Value& a, const Value& b) {
     return PyNone{};
 }
 
-void EvalVisitor::pushScope() { scopes.push_back({}); }
-void EvalVisitor::popScope() { scopes.pop_back(); }
+// ============== Variables ==============
+EvalVisitor::Symbol EvalVisitor::intern(const std::string& name) {
+    auto [it, added] = symbolIds.try_emplace(name, (Symbol)symbolNames.size());
+    if (added) symbolNames.push_back(name);
+    return it->second;
+}
+
+EvalVisitor::NameRef& EvalVisitor::nameRef(antlr4::tree::TerminalNode* name) {
+    size_t t = name->getSymbol()->getTokenIndex();
+    if (t >= nameRefs.size()) nameRefs.resize(t + 1);
+    NameRef& ref = nameRefs[t];
+    if (ref.symbol == NO_SYMBOL) ref.symbol = intern(name->getText());
+    return ref;
+}
+
+// Name of a plain variable (`x`, not `x(...)` or `x + 1`) written as a test, else nullptr
+static antlr4::tree::TerminalNode* nameOfTest(Python3Parser::TestContext* t) {
+    auto* f = t->or_test()->and_test(0)->not_test(0)->comparison()->arith_expr(0)->term(0)->factor(0)->atom_expr();
+    if (f->atom()->NAME() && !f->trailer()) return f->atom()->NAME();
+    return nullptr;
+}
 
-Value EvalVisitor::getVar(const std::string& name) {
-    for (int i = (int)scopes.size() - 1; i >= 0; i--) {
-        auto it = scopes[i].find(name);
-        if (it != scopes[i].end()) return it->second;
+// Calls visit on every node below t except the bodies of nested function definitions,
+// whose names are resolved when they are defined (their defaults belong to this body)
+template <class F>
+static void walkBody(antlr4::tree::ParseTree* t, const F& visit) {
+    for (auto* c : t->children) {
+        if (auto* def = dynamic_cast<Python3Parser::FuncdefContext*>(c)) {
+            walkBody(def->parameters(), visit);
+            continue;
+        }
+        visit(c);
+        walkBody(c, visit);
     }
-    throw std::runtime_error("name '" + name + "' is not defined");
 }
 
-void EvalVisitor::setVar(const std::string& name, const Value& v) {
-    for (int i = (int)scopes.size() - 1; i >= 0; i--) {
-        auto it = scopes[i].find(name);
-        if (it != scopes[i].end()) { scopes[i][name] = v; return; }
+void EvalVisitor::resolveLocals(Python3Parser::FuncdefContext* ctx, Function& f) {
+    std::unordered_map<Symbol, int>& slots = f.slots;
+    for (size_t i = 0; i < f.params.size(); i++) slots.emplace(f.params[i], (int)i);
+    // Every assignment target in the body gets a slot
+    walkBody(ctx->suite(), [&](antlr4::tree::ParseTree* t) {
+        auto* stmt = dynamic_cast<Python3Parser::Expr_stmtContext*>(t);
+        if (!stmt || (!stmt->augassign() && stmt->ASSIGN().empty())) return;
+        auto lists = stmt->testlist();
+        for (size_t i = 0; i + 1 < lists.size(); i++) {
+            for (auto* test : lists[i]->test()) {
+                if (auto* name = nameOfTest(test)) slots.emplace(symbolOf(name), (int)slots.size());
+            }
+        }
+    });
+    walkBody(ctx->suite(), [&](antlr4::tree::ParseTree* t) {
+        auto* atom = dynamic_cast<Python3Parser::AtomContext*>(t);
+        if (!atom || !atom->NAME()) return;
+        NameRef& ref = nameRef(atom->NAME());
+        ref.slot = -1;
+        ref.depth = 0;
+        auto it = slots.find(ref.symbol);
+        if (it != slots.end()) {
+            ref.slot = it->second;
+            return;
+        }
+        for (size_t d = 0; d < f.outer.size(); d++) {
+            const auto& outerSlots = f.outer[d].function->slots;
+            auto o = outerSlots.find(ref.symbol);
+            if (o != outerSlots.end()) {
+                ref.slot = o->second;
+                ref.depth = (int)d + 1;
+                return;
+            }
+        }
+    });
+}
+
+std::optional<Value>* EvalVisitor::localSlot(const NameRef& ref) {
+    if (ref.depth == 0) return &stack[frameBase + ref.slot];
+    const Enclosing& e = calls.back().function->outer[ref.depth - 1];
+    if (e.call >= calls.size() || calls[e.call].serial != e.serial) return nullptr;
+    return &stack[calls[e.call].base + ref.slot];
+}
+
+// A local slot that is unbound, or belongs to an enclosing call that has returned, falls
+// through to the global of the same name
+Value* EvalVisitor::findVar(const NameRef& ref) {
+    if (ref.slot >= 0) {
+        std::optional<Value>* v = ref.depth == 0 ? &stack[frameBase + ref.slot] : localSlot(ref);
+        if (v && *v) return &**v;
+    }
+    auto it = globals.find(ref.symbol);
+    return it != globals.end() ? &it->second : nullptr;
+}
+
+Value EvalVisitor::getVar(const NameRef& ref) {
+    if (Value* v = findVar(ref)) return *v;
+    throw std::runtime_error("name '" + symbolNames[ref.symbol] + "' is not defined");
+}
+
+void EvalVisitor::setVar(const NameRef& ref, const Value& v) {
+    if (Value* slot = findVar(ref)) {
+        *slot = v;
+    } else {
+        std::optional<Value>* local = ref.slot >= 0 ? localSlot(ref) : nullptr;
+        if (local) *local = v;
+        else globals[ref.symbol] = v;
     }
-    scopes.back()[name] = v;
 }
 
 // ============== Visitors ==============
+// Every script-level call nests a few dozen visitor calls on the native stack, so the
+// program runs on a thread whose stack is this big (address space only; pages are touched
+// as deep as the script actually recurses)
+static constexpr size_t EVAL_STACK_BYTES = size_t(1) << 30;
+// Frame slots reserved up front, enough for deep recursion without regrowing the stack
+static constexpr size_t FRAME_STACK_RESERVE = size_t(1) << 16;
+
+// Runs body on a thread with an EVAL_STACK_BYTES stack, or in place if none can be made;
+// an exception thrown by body is rethrown here
+template <class F>
+static void runOnLargeStack(F body) {
+    std::exception_ptr error;
+    auto task = [&] {
+        try {
+            body();
+        } catch (...) {
+            error = std::current_exception();
+        }
+    };
+    using Task = decltype(task);
+    pthread_attr_t attr;
+    pthread_t thread;
+    pthread_attr_init(&attr);
+    bool started = pthread_attr_setstacksize(&attr, EVAL_STACK_BYTES) == 0 &&
+                   pthread_create(&thread, &attr, [](void* t) -> void* { (*static_cast<Task*>(t))(); return nullptr; }, &task) == 0;
+    pthread_attr_destroy(&attr);
+    if (started) pthread_join(thread, nullptr);
+    else task();
+    if (error) std::rethrow_exception(error);
+}
+
 std::any EvalVisitor::visitFile_input(Python3Parser::File_inputContext *ctx) {
-    pushScope();
-    for (auto* s : ctx->stmt()) visit(s);
-    popScope();
+    nameRefs.resize(ctx->getStop()->getTokenIndex() + 1);
+    callPlans.resize(nameRefs.size());
+    stack.reserve(FRAME_STACK_RESERVE);
+    runOnLargeStack([&] {
+        for (auto* s : ctx->stmt()) {
+            visit(s);
+            if (flow != FlowType::Normal) break;  // a stray return ends the program, as it did before
+        }
+    });
     return nullptr;
 }
 
 std::any EvalVisitor::visitFuncdef(Python3Parser::FuncdefContext *ctx) {
-    std::string name = ctx->NAME()->getText();
+    Symbol name = symbolOf(ctx->NAME());
     auto* paramsCtx = ctx->parameters()->typedargslist();
-    std::vector<std::string> names;
+    std::vector<Symbol> names;
     std::vector<Value> defaults;
     if (paramsCtx) {
         for (auto* tfp : paramsCtx->tfpdef())
-            names.push_back(tfp->NAME()->getText());
+            names.push_back(symbolOf(tfp->NAME()));
         for (auto* t : paramsCtx->test()) {
             Value v = std::any_cast<Value>(visit(t));
             defaults.push_back(v);
         }
     }
-    functions[name] = {names, defaults, ctx->suite()};
+    auto f = std::make_shared<Function>(Function{std::move(names), std::move(defaults), ctx->suite(), {}, ++definitions, {}});
+    if (!calls.empty()) {  // a nested def: it can read the locals of the calls running now
+        const Call& c = calls.back();
+        f->outer.push_back({c.function, calls.size() - 1, c.serial});
+        f->outer.insert(f->outer.end(), c.function->outer.begin(), c.function->outer.end());
+    }
+    resolveLocals(ctx, *f);
+    functions[name] = std::move(f);
     return nullptr;
 }
 
@@ -349,53 +557,53 @@ std::any EvalVisitor::visitSmall_stmt(Python3Parser::Small_stmtContext *ctx) {
     return visit(ctx->flow_stmt());
 }
 
-static std::string getSingleName(Python3Parser::TestlistContext* tl) {
-    if (!tl || tl->test().size() != 1) return "";
-    auto* f = tl->test(0)->or_test()->and_test(0)->not_test(0)->comparison()->arith_expr(0)->term(0)->factor(0)->atom_expr();
-    if (f->atom()->NAME() && !f->trailer()) return f->atom()->NAME()->getText();
-    return "";
+static antlr4::tree::TerminalNode* getSingleName(Python3Parser::TestlistContext* tl) {
+    if (!tl || tl->test().size() != 1) return nullptr;
+    return nameOfTest(tl->test(0));
 }
 
 std::any EvalVisitor::visitExpr_stmt(Python3Parser::Expr_stmtContext *ctx) {
     auto testlists = ctx->testlist();
     if (ctx->augassign()) {
-        std::string name = getSingleName(testlists[0]);
-        if (!name.empty()) {
-            Value left = getVar(name);
+        if (auto* nameNode = getSingleName(testlists[0])) {
+            NameRef name = nameRef(nameNode);
             Value right = std::any_cast<Value>(visit(testlists[1]));
+            // Update the variable's value where it lives; the slot is looked up after the
+            // right-hand side has run, since a call there may push and pop frames.
+            Value* slot = findVar(name);
+            if (!slot) throw std::runtime_error("name '" + symbolNames[name.symbol] + "' is not defined");
+            Value& left = *slot;
             std::string op = ctx->augassign()->getText();
-            Value res;
             if (op == "+=") {
-                if (std::holds_alternative<BigInt>(left) && std::holds_alternative<BigInt>(right))
-                    res = std::get<BigInt>(left) + std::get<BigInt>(toInt(right));
+                if (isInt(left) && isInt(right))
+                    intAddInPlace(left, right);
                 else if (std::holds_alternative<double>(left) || std::holds_alternative<double>(right))
-                    res = std::get<double>(toFloat(left)) + std::get<double>(toFloat(right));
+                    left = std::get<double>(toFloat(left)) + std::get<double>(toFloat(right));
                 else if (std::holds_alternative<std::string>(left) && std::holds_alternative<std::string>(right))
-                    res = std::get<std::string>(left) + std::get<std::string>(toStr(right));
+                    std::get<std::string>(left) += std::get<std::string>(right);
                 else
-                    res = std::get<BigInt>(toInt(left)) + std::get<BigInt>(toInt(right));
+                    left = intAdd(toInt(left), toInt(right));
             } else if (op == "-=") {
-                if (std::holds_alternative<BigInt>(left)) res = std::get<BigInt>(left) - std::get<BigInt>(toInt(right));
-                else res = std::get<double>(toFloat(left)) - std::get<double>(toFloat(right));
+                if (isInt(left)) intSubInPlace(left, toInt(right));
+                else left = std::get<double>(toFloat(left)) - std::get<double>(toFloat(right));
             } else if (op == "*=") {
-                if (std::holds_alternative<std::string>(left) && std::holds_alternative<BigInt>(right)) {
-                    std::string s; int n = std::get<BigInt>(right).toLong();
+                if (std::holds_alternative<std::string>(left) && std::holds_alternative<long long>(right)) {
+                    std::string s; long long n = std::get<long long>(right);
                     for (int j = 0; j < n; j++) s += std::get<std::string>(left);
-                    res = s;
-                } else if (std::holds_alternative<BigInt>(left) && std::holds_alternative<BigInt>(right))
-                    res = std::get<BigInt>(left) * std::get<BigInt>(right);
+                    left = s;
+                } else if (isInt(left) && isInt(right))
+                    intMulInPlace(left, right);
                 else
-                    res = std::get<double>(toFloat(left)) * std::get<double>(toFloat(right));
+                    left = std::get<double>(toFloat(left)) * std::get<double>(toFloat(right));
             } else if (op == "/=")
-                res = std::get<double>(toFloat(left)) / std::get<double>(toFloat(right));
+                left = std::get<double>(toFloat(left)) / std::get<double>(toFloat(right));
             else if (op == "//=") {
-                if (std::holds_alternative<BigInt>(left)) res = floorDiv(std::get<BigInt>(left), std::get<BigInt>(toInt(right)));
-                else res = BigInt((long long)(std::get<double>(toFloat(left)) / std::get<double>(toFloat(right))));
+                if (isInt(left)) left = intFloorDiv(left, toInt(right));
+                else left = (long long)(std::get<double>(toFloat(left)) / std::get<double>(toFloat(right)));
             } else if (op == "%=") {
-                if (std::holds_alternative<BigInt>(left)) res = floorMod(std::get<BigInt>(left), std::get<BigInt>(toInt(right)));
-                else res = std::fmod(std::get<double>(toFloat(left)), std::get<double>(toFloat(right)));
+                if (isInt(left)) left = intFloorMod(left, toInt(right));
+                else left = std::fmod(std::get<double>(toFloat(left)), std::get<double>(toFloat(right)));
             }
-            setVar(name, res);
             return nullptr;
         }
         return nullptr;  // augassign but not single name (e.g. a[i] += x)
@@ -417,12 +625,12 @@ std::any EvalVisitor::visitExpr_stmt(Python3Parser::Expr_stmtContext *ctx) {
         size_t idx = 0;
         for (size_t i = 0; i < n - 1; i++) {
             for (auto* t : testlists[i]->test()) {
-                std::string name = t->or_test()->and_test(0)->not_test(0)->comparison()->arith_expr(0)->term(0)->factor(0)->atom_expr()->atom()->NAME()->getText();
-                setVar(name, rhsList[idx++]);
+                auto* name = t->or_test()->and_test(0)->not_test(0)->comparison()->arith_expr(0)->term(0)->factor(0)->atom_expr()->atom()->NAME();
+                setVar(nameRef(name), rhsList[idx++]);
             }
         }
     } else if (lhsCount == 1 && rhsList.size() == 1) {
-        setVar(getSingleName(testlists[0]), rhsList[0]);
+        if (auto* name = getSingleName(testlists[0])) setVar(nameRef(name), rhsList[0]);
     }
     return nullptr;
 }
@@ -438,19 +646,19 @@ std::any EvalVisitor::visitFlow_stmt(Python3Parser::Flow_stmtContext *ctx) {
 }
 
 std::any EvalVisitor::visitBreak_stmt(Python3Parser::Break_stmtContext *ctx) {
-    throw FlowType::Break;
+    flow = FlowType::Break;
+    return nullptr;
 }
 
 std::any EvalVisitor::visitContinue_stmt(Python3Parser::Continue_stmtContext *ctx) {
-    throw FlowType::Continue;
+    flow = FlowType::Continue;
+    return nullptr;
 }
 
 std::any EvalVisitor::visitReturn_stmt(Python3Parser::Return_stmtContext *ctx) {
-    if (ctx->testlist()) {
-        Value v = std::any_cast<Value>(visit(ctx->testlist()));
-        throw std::make_pair(FlowType::Return, std::move(v));
-    }
-    throw std::make_pair(FlowType::Return, Value(PyNone{}));
+    returnValue = ctx->testlist() ? std::any_cast<Value>(visit(ctx->testlist())) : Value(PyNone{});
+    flow = FlowType::Return;
+    return nullptr;
 }
 
 std::any EvalVisitor::visitCompound_stmt(Python3Parser::Compound_stmtContext *ctx) {
@@ -473,20 +681,21 @@ std::any EvalVisitor::visitWhile_stmt(Python3Parser::While_stmtContext *ctx) {
     while (true) {
         Value c = std::any_cast<Value>(visit(ctx->test()));
         if (!isTrue(c)) break;
-        try {
-            visit(ctx->suite());
-        } catch (FlowType f) {
-            if (f == FlowType::Break) break;
-            if (f == FlowType::Continue) continue;
-            throw;
-        }
+        visit(ctx->suite());
+        if (flow == FlowType::Return) break;
+        FlowType f = flow;
+        flow = FlowType::Normal;
+        if (f == FlowType::Break) break;
     }
     return nullptr;
 }
 
 std::any EvalVisitor::visitSuite(Python3Parser::SuiteContext *ctx) {
     if (ctx->simple_stmt()) return visit(ctx->simple_stmt());
-    for (auto* s : ctx->stmt()) visit(s);
+    for (auto* s : ctx->stmt()) {
+        visit(s);
+        if (flow != FlowType::Normal) break;
+    }
     return nullptr;
 }
 
@@ -553,17 +762,37 @@ std::any EvalVisitor::visitComparison(Python3Parser::ComparisonContext *ctx) {
 }
 
 std::any EvalVisitor::visitArith_expr(Python3Parser::Arith_exprContext *ctx) {
-    Value v = std::any_cast<Value>(visit(ctx->term(0)));
+    return evalArith(ctx);
+}
+
+// The running sum v is always a value of its own, so BigInt sums update its buffer in
+// place, and a term that is a product of two ints is multiply-accumulated into it.
+// Terms and factors are evaluated directly rather than through visit() and std::any.
+Value EvalVisitor::evalArith(Python3Parser::Arith_exprContext *ctx) {
+    Value v = evalTerm(ctx->term(0));
     for (size_t i = 0; i < ctx->addorsub_op().size(); i++) {
-        Value r = std::any_cast<Value>(visit(ctx->term(i + 1)));
         bool sub = ctx->addorsub_op(i)->MINUS() != nullptr;
-        if (std::holds_alternative<BigInt>(v) && std::holds_alternative<BigInt>(r)) {
-            v = sub ? std::get<BigInt>(v) - std::get<BigInt>(r) : std::get<BigInt>(v) + std::get<BigInt>(r);
+        auto* term = ctx->term(i + 1);
+        Value r;
+        if (isInt(v) && term->factor().size() == 2 && term->muldivmod_op(0)->STAR()) {
+            Value x = evalFactor(term->factor(0));
+            Value y = evalFactor(term->factor(1));
+            if (isInt(x) && isInt(y)) {
+                intAddMulInPlace(v, x, y, sub);
+                continue;
+            }
+            r = applyMulOp(term->muldivmod_op(0), std::move(x), y);
+        } else {
+            r = evalTerm(term);
+        }
+        if (isInt(v) && isInt(r)) {
+            if (sub) intSubInPlace(v, r);
+            else intAddInPlace(v, r);
         } else if (std::holds_alternative<std::string>(v) && std::holds_alternative<std::string>(r) && !sub) {
-            v = std::get<std::string>(v) + std::get<std::string>(r);
+            std::get<std::string>(v) += std::get<std::string>(r);
         } else {
-            double a = std::holds_alternative<BigInt>(v) ? (double)std::get<BigInt>(v).toLong() : std::get<double>(toFloat(v));
-            double b = std::holds_alternative<BigInt>(r) ? (double)std::get<BigInt>(r).toLong() : std::get<double>(toFloat(r));
+            double a = std::get<double>(toFloat(v));
+            double b = std::get<double>(toFloat(r));
             v = sub ? a - b : a + b;
         }
     }
@@ -571,43 +800,54 @@ std::any EvalVisitor::visitArith_expr(Python3Parser::Arith_exprContext *ctx) {
 }
 
 std::any EvalVisitor::visitTerm(Python3Parser::TermContext *ctx) {
-    Value v = std::any_cast<Value>(visit(ctx->factor(0)));
-    for (size_t i = 0; i < ctx->muldivmod_op().size(); i++) {
-        Value r = std::any_cast<Value>(visit(ctx->factor(i + 1)));
-        auto* op = ctx->muldivmod_op(i);
-        if (op->STAR()) {
-            if (std::holds_alternative<BigInt>(v) && std::holds_alternative<BigInt>(r))
-                v = std::get<BigInt>(v) * std::get<BigInt>(r);
-            else if (std::holds_alternative<std::string>(v) && std::holds_alternative<BigInt>(r)) {
-                std::string s; int n = std::get<BigInt>(r).toLong();
-                for (int j = 0; j < n; j++) s += std::get<std::string>(v);
-                v = s;
-            } else
-                v = std::get<double>(toFloat(v)) * std::get<double>(toFloat(r));
-        } else if (op->DIV())
-            v = std::get<double>(toFloat(v)) / std::get<double>(toFloat(r));
-        else if (op->IDIV()) {
-            if (std::holds_alternative<BigInt>(v) && std::holds_alternative<BigInt>(r))
-                v = floorDiv(std::get<BigInt>(v), std::get<BigInt>(r));
-            else
-                v = BigInt((long long)(std::get<double>(toFloat(v)) / std::get<double>(toFloat(r))));
-        } else if (op->MOD()) {
-            if (std::holds_alternative<BigInt>(v) && std::holds_alternative<BigInt>(r))
-                v = floorMod(std::get<BigInt>(v), std::get<BigInt>(r));
-            else
-                v = std::fmod(std::get<double>(toFloat(v)), std::get<double>(toFloat(r)));
-        }
+    return evalTerm(ctx);
+}
+
+Value EvalVisitor::evalTerm(Python3Parser::TermContext *ctx) {
+    Value v = evalFactor(ctx->factor(0));
+    for (size_t i = 0; i < ctx->muldivmod_op().size(); i++)
+        v = applyMulOp(ctx->muldivmod_op(i), std::move(v), evalFactor(ctx->factor(i + 1)));
+    return v;
+}
+
+// One *, /, // or % step of a term; v is consumed, so an int product reuses its buffer
+Value EvalVisitor::applyMulOp(Python3Parser::Muldivmod_opContext *op, Value v, const Value& r) {
+    if (op->STAR()) {
+        if (isInt(v) && isInt(r))
+            intMulInPlace(v, r);
+        else if (std::holds_alternative<std::string>(v) && std::holds_alternative<long long>(r)) {
+            std::string s; long long n = std::get<long long>(r);
+            for (int j = 0; j < n; j++) s += std::get<std::string>(v);
+            v = s;
+        } else
+            v = std::get<double>(toFloat(v)) * std::get<double>(toFloat(r));
+    } else if (op->DIV())
+        v = std::get<double>(toFloat(v)) / std::get<double>(toFloat(r));
+    else if (op->IDIV()) {
+        if (isInt(v) && isInt(r))
+            v = intFloorDiv(v, r);
+        else
+            v = (long long)(std::get<double>(toFloat(v)) / std::get<double>(toFloat(r)));
+    } else if (op->MOD()) {
+        if (isInt(v) && isInt(r))
+            v = intFloorMod(v, r);
+        else
+            v = std::fmod(std::get<double>(toFloat(v)), std::get<double>(toFloat(r)));
     }
     return v;
 }
 
 std::any EvalVisitor::visitFactor(Python3Parser::FactorContext *ctx) {
+    return evalFactor(ctx);
+}
+
+Value EvalVisitor::evalFactor(Python3Parser::FactorContext *ctx) {
     Value v;
     if (ctx->atom_expr())
         v = std::any_cast<Value>(visit(ctx->atom_expr()));
     else
-        v = std::any_cast<Value>(visit(ctx->factor()));
-    if (ctx->MINUS()) return std::holds_alternative<BigInt>(v) ? Value(-std::get<BigInt>(v)) : Value(-std::get<double>(toFloat(v)));
+        v = evalFactor(ctx->factor());
+    if (ctx->MINUS()) return isInt(v) ? intNeg(v) : Value(-std::get<double>(toFloat(v)));
     if (ctx->ADD()) return v;
     return v;
 }
@@ -622,11 +862,42 @@ std::any EvalVisitor::visitAtom_expr(Python3Parser::Atom_exprContext *ctx) {
     return visit(ctx->atom());
 }
 
+std::shared_ptr<const EvalVisitor::CallPlan> EvalVisitor::callPlan(Python3Parser::TrailerContext* ctx, const Function& fn) {
+    std::shared_ptr<const CallPlan>& cached = callPlans[ctx->getStart()->getTokenIndex()];
+    if (cached && cached->function == fn.id) return cached;
+    auto plan = std::make_shared<CallPlan>();
+    plan->function = fn.id;
+    // Keyword arguments go to the parameter of that name, unless a positional argument
+    // already filled it; arguments that match no parameter are still evaluated
+    size_t p = fn.params.size(), positional = 0;
+    std::vector<bool> bound(p);
+    if (ctx->arglist()) {
+        for (auto* arg : ctx->arglist()->argument()) {
+            size_t i;
+            if (arg->ASSIGN()) {
+                Symbol name = symbolOf(nameOfTest(arg->test(0)));
+                i = std::find(fn.params.begin(), fn.params.end(), name) - fn.params.begin();
+                if (i < positional) i = p;
+            } else {
+                i = positional++;
+            }
+            plan->args.emplace_back(arg->test(arg->ASSIGN() ? 1 : 0), i < p ? (int)i : -1);
+            if (i < p) bound[i] = true;
+        }
+    }
+    for (size_t i = p - fn.defaults.size(); i < p; i++) {
+        if (!bound[i]) plan->defaults.push_back(i);
+    }
+    cached = plan;
+    return plan;
+}
+
 std::any EvalVisitor::visitTrailer(Python3Parser::TrailerContext *ctx) {
     if (!currentAtomExpr || !currentAtomExpr->atom()->NAME()) return nullptr;
-    std::string funcName = currentAtomExpr->atom()->NAME()->getText();
-    auto it = functions.find(funcName);
+    Symbol callee = symbolOf(currentAtomExpr->atom()->NAME());
+    auto it = functions.find(callee);
     if (it == functions.end()) {
+        std::string funcName = symbolNames[callee];
         if (funcName == "print") {
             auto* arglist = ctx->arglist();
             std::vector<std::string> parts;
@@ -660,55 +931,111 @@ std::any EvalVisitor::visitTrailer(Python3Parser::TrailerContext *ctx) {
             Value v = std::any_cast<Value>(visit(ctx->arglist()->argument(0)->test(0)));
             return toBool(v);
         }
-    } else {
-        auto& [paramNames, defaultValues, suiteCtx] = it->second;
-        std::map<std::string, Value> kwargs;
-        std::vector<Value> args;
-        if (ctx->arglist()) {
-            auto* al = ctx->arglist();
-            for (size_t i = 0; i < al->argument().size(); i++) {
-                auto* arg = al->argument(i);
-                if (arg->ASSIGN()) {
-                    std::string name = arg->test(0)->or_test()->and_test(0)->not_test(0)->comparison()->arith_expr(0)->term(0)->factor(0)->atom_expr()->atom()->NAME()->getText();
-                    kwargs[name] = std::any_cast<Value>(visit(arg->test(1)));
-                } else {
-                    args.push_back(std::any_cast<Value>(visit(arg->test(0))));
-                }
+        if (funcName == "divmod") {
+            size_t given = ctx->arglist() ? ctx->arglist()->argument().size() : 0;
+            if (given != 2) throw std::runtime_error("divmod expected 2 arguments, got " + std::to_string(given));
+            Value a = std::any_cast<Value>(visit(ctx->arglist()->argument(0)->test(0)));
+            Value b = std::any_cast<Value>(visit(ctx->arglist()->argument(1)->test(0)));
+            if (std::holds_alternative<bool>(a)) a = toInt(a);
+            if (std::holds_alternative<bool>(b)) b = toInt(b);
+            auto tup = std::make_shared<PyTuple>();
+            if (isInt(a) && isInt(b)) {
+                auto [q, r] = intDivMod(a, b);
+                tup->elts = {std::move(q), std::move(r)};
+            } else {
+                double x = std::get<double>(toFloat(a)), y = std::get<double>(toFloat(b));
+                if (y == 0.0) throw std::runtime_error("division by zero");
+                double r = std::fmod(x, y);
+                if (r != 0.0 && ((r < 0) != (y < 0))) r += y;
+                tup->elts = {std::floor((x - r) / y), r};
             }
+            return Value(tup);
         }
-        pushScope();
-        size_t p = paramNames.size();
-        size_t defStart = p - defaultValues.size();
-        for (size_t i = 0; i < p; i++) {
-            if (i < args.size())
-                setVar(paramNames[i], args[i]);
-            else if (kwargs.count(paramNames[i]))
-                setVar(paramNames[i], kwargs[paramNames[i]]);
-            else if (i >= defStart)
-                setVar(paramNames[i], defaultValues[i - defStart]);
+        if (funcName == "abs" || funcName == "pow" || funcName == "gcd" || funcName == "isqrt") {
+            std::vector<Value> args;
+            if (ctx->arglist()) {
+                for (auto* arg : ctx->arglist()->argument()) {
+                    Value v = std::any_cast<Value>(visit(arg->test(0)));
+                    args.push_back(std::holds_alternative<bool>(v) ? toInt(v) : v);
+                }
+            }
+            return callNumberBuiltin(funcName, args);
         }
-        try {
-            visit(suiteCtx);
-            popScope();
-            return Value(PyNone{});
-        } catch (const std::pair<FlowType, Value>& ret) {
-            popScope();
-            if (ret.first == FlowType::Return) return ret.second;
-            throw;
+    } else {
+        std::shared_ptr<const Function> function = it->second;
+        const Function& fn = *function;
+        Python3Parser::SuiteContext* body = fn.body;
+        // The call owns its definition and plan: evaluating an argument may redefine the
+        // callee or rebuild this site's plan, and this call still binds and runs the
+        // definition it looked up, which the plan was made for
+        std::shared_ptr<const CallPlan> plan = callPlan(ctx, fn);
+        // The callee's frame goes on top of the stack before the arguments are evaluated, so
+        // each argument is stored straight into its parameter's slot; calls made while
+        // evaluating them use the stack above it. Parameters are always locals of the new
+        // frame, even when a global has the same name.
+        size_t base = stack.size();
+        stack.resize(base + fn.slots.size());
+        for (const auto& [expr, slot] : plan->args) {
+            Value v = std::any_cast<Value>(visit(expr));
+            if (slot >= 0) stack[base + slot] = std::move(v);
         }
+        size_t defStart = fn.params.size() - fn.defaults.size();
+        for (size_t i : plan->defaults) stack[base + i] = fn.defaults[i - defStart];
+        size_t callerBase = frameBase;
+        frameBase = base;
+        calls.push_back({base, ++callSerial, std::move(function)});
+        visit(body);
+        calls.pop_back();
+        frameBase = callerBase;
+        stack.resize(base);
+        if (flow != FlowType::Return) return Value(PyNone{});
+        flow = FlowType::Normal;
+        return std::move(returnValue);
     }
     return nullptr;
 }
 
+Value EvalVisitor::callNumberBuiltin(const std::string& name, const std::vector<Value>& args) {
+    size_t least = name == "abs" || name == "isqrt" ? 1 : 2, most = name == "pow" ? 3 : least;
+    if (args.size() < least || args.size() > most) {
+        const char* expected = least == 1 ? "exactly one argument" : most == 3 ? "2 or 3 arguments" : "exactly 2 arguments";
+        throw std::runtime_error(name + "() takes " + expected + " (" + std::to_string(args.size()) + " given)");
+    }
+    for (const Value& v : args) {
+        if (!isInt(v) && !(std::holds_alternative<double>(v) && (name == "abs" || (name == "pow" && args.size() == 2))))
+            throw std::runtime_error("'" + name + "' argument must be an integer");
+    }
+    if (name == "abs") {
+        if (std::holds_alternative<double>(args[0])) return std::fabs(std::get<double>(args[0]));
+        return intAbs(args[0]);
+    }
+    if (name == "gcd") return intGcd(args[0], args[1]);
+    if (name == "isqrt") return intIsqrt(args[0]);
+    // pow
+    if (args.size() == 3) return intPowMod(args[0], args[1], args[2]);
+    const Value &a = args[0], &e = args[1];
+    if (!isInt(a) || !isInt(e) || (std::holds_alternative<long long>(e) ? std::get<long long>(e) < 0 : std::get<BigInt>(e) < BigInt(0)))
+        return std::pow(std::get<double>(toFloat(a)), std::get<double>(toFloat(e)));
+    if (std::holds_alternative<BigInt>(e)) {  // beyond long long: only 0, 1 and -1 have a representable power
+        long long x = std::holds_alternative<long long>(a) ? std::get<long long>(a) : 2;
+        if (x < -1 || x > 1) throw std::runtime_error("pow() exponent too large");
+        return x == -1 && std::get<long long>(intFloorMod(e, 2LL)) == 0 ? 1LL : x;
+    }
+    return intPow(a, std::get<long long>(e));
+}
+
 std::any EvalVisitor::visitAtom(Python3Parser::AtomContext *ctx) {
     if (ctx->NAME()) {
-        return getVar(ctx->NAME()->getText());
+        return getVar(nameRef(ctx->NAME()));
     }
     if (ctx->NUMBER()) {
         std::string text = ctx->NUMBER()->getText();
         if (text.find('.') != std::string::npos)
             return Value(std::stod(text));
-        return Value(BigInt(text));
+        if (text.size() <= 18) return Value(std::stoll(text));
+        BigInt x(text);
+        BigIntTrace::record("parse", {&x});
+        return normalizeInt(std::move(x));
     }
     if (ctx->STRING().size() > 0) {
         std::string s;
@@ -755,7 +1082,7 @@ std::any EvalVisitor::visitFormat_string(Python3Parser::Format_stringContext *ct
         } else if (auto* tl = dynamic_cast<Python3Parser::TestlistContext*>(child)) {
             Value v = std::any_cast<Value>(visit(tl));
             if (std::holds_alternative<bool>(v)) res += std::get<bool>(v) ? "True" : "False";
-            else if (std::holds_alternative<BigInt>(v)) res += std::get<BigInt>(v).toString();
+            else if (isInt(v)) res += std::get<std::string>(toStr(v));
             else if (std::holds_alternative<double>(v)) res += formatFloat(std::get<double>(v));
             else if (std::holds_alternative<std::string>(v)) res += std::get<std::string>(v);
             else if (std::holds_alternative<PyNone>(v)) res += "None";
@@ -3,9 +3,11 @@
 #define PYTHON_INTERPRETER_EVALVISITOR_H
 
 #include "Python3ParserBaseVisitor.h"
+#include "BigInt.h"
 #include <string>
 #include <vector>
 #include <map>
+#include <unordered_map>
 #include <variant>
 #include <optional>
 #include <memory>
@@ -13,53 +15,10 @@
 #include <iomanip>
 #include <stdexcept>
 
-// Arbitrary precision integer
-class BigInt {
-public:
-    BigInt() : negative(false), digits("0") {}
-    BigInt(long long n);
-    explicit BigInt(const std::string& s);
-
-    std::string toString() const;
-    long long toLong() const;  // for int() conversion when in range
-    bool isZero() const { return digits == "0" || digits.empty(); }
-
-    BigInt operator-() const;
-    BigInt operator+(const BigInt& o) const;
-    BigInt operator-(const BigInt& o) const;
-    BigInt operator*(const BigInt& o) const;
-    BigInt operator/(const BigInt& o) const;  // floor division
-    BigInt operator%(const BigInt& o) const;
-
-    bool operator<(const BigInt& o) const;
-    bool operator>(const BigInt& o) const;
-    bool operator<=(const BigInt& o) const;
-    bool operator>=(const BigInt& o) const;
-    bool operator==(const BigInt& o) const;
-    bool operator!=(const BigInt& o) const;
-
-    BigInt& operator+=(const BigInt& o);
-    BigInt& operator-=(const BigInt& o);
-    BigInt& operator*=(const BigInt& o);
-    BigInt& operator/=(const BigInt& o);
-    BigInt& operator%=(const BigInt& o);
-
-private:
-    bool negative;
-    std::string digits;  // absolute value, no leading zeros
-
-    static std::string add(const std::string& a, const std::string& b);
-    static std::string sub(const std::string& a, const std::string& b);
-    static std::string mul(const std::string& a, const std::string& b);
-    static std::string divmod(const std::string& a, const std::string& b, std::string& rem);
-    static int compare(const std::string& a, const std::string& b);
-    static std::string trimZeros(std::string s);
-};
-
-// Value type: None, int (BigInt), float, bool, str, tuple (for multiple return/assign)
+// Value type: None, int (long long when it fits, else BigInt), float, bool, str, tuple (for multiple return/assign)
 struct PyNone {};
 struct PyTuple;  // forward
-using Value = std::variant<PyNone, BigInt, double, bool, std::string, std::shared_ptr<PyTuple>>;
+using Value = std::variant<PyNone, long long, BigInt, double, bool, std::string, std::shared_ptr<PyTuple>>;
 struct PyTuple { std::vector<Value> elts; };
 
 enum class FlowType { Normal, Return, Break, Continue };
@@ -99,20 +58,87 @@ public:
     std::any visitArgument(Python3Parser::ArgumentContext *ctx) override;
 
 private:
-    std::vector<std::map<std::string, Value>> scopes;
-    std::map<std::string, std::tuple<std::vector<std::string>, std::vector<Value>, Python3Parser::SuiteContext*>> functions;
+    // Names are interned to dense ids. When a function is defined, its parameters and the
+    // names it assigns are numbered as slots of a flat per-call frame. A name it only reads is
+    // a local of the nearest enclosing function that has one, else a global, kept in a table
+    // keyed by symbol. Each NAME token's resolution is stored by token index, so an access is
+    // an array load plus, for globals, one hashed probe.
+    using Symbol = uint32_t;
+    static constexpr Symbol NO_SYMBOL = ~Symbol(0);
+    struct NameRef {
+        Symbol symbol = NO_SYMBOL;
+        int slot = -1;  // frame slot for a function local, -1 for a global
+        int depth = 0;  // 0 for the running call's frame, n for that of the n-th enclosing function
+    };
+    struct Function;
+    // The call of an enclosing function that was running when a nested def executed
+    struct Enclosing {
+        std::shared_ptr<const Function> function;
+        size_t call;  // index in `calls`
+        uint64_t serial;  // Call::serial, to tell whether that call is still running
+    };
+    struct Function {
+        std::vector<Symbol> params;  // parameter i lives in slot i
+        std::vector<Value> defaults;
+        Python3Parser::SuiteContext* body;
+        std::unordered_map<Symbol, int> slots;
+        unsigned id;  // distinct for every execution of a def
+        std::vector<Enclosing> outer;  // innermost first; empty for a module-level def
+    };
+    struct Call {
+        size_t base;  // first frame slot
+        uint64_t serial;
+        std::shared_ptr<const Function> function;
+    };
+    // How one call site's arguments bind to a function's parameters, worked out on its first
+    // call to a given definition
+    struct CallPlan {
+        unsigned function = 0;  // Function::id the plan was made for
+        std::vector<std::pair<Python3Parser::TestContext*, int>> args;  // expression and slot, -1 to drop
+        std::vector<size_t> defaults;  // slots the call leaves to their default
+    };
+    std::unordered_map<std::string, Symbol> symbolIds;
+    std::vector<std::string> symbolNames;
+    std::vector<NameRef> nameRefs;  // by token index
+    std::unordered_map<Symbol, Value> globals;
+    // Call frames laid out back to back: the running call's slots are
+    // [frameBase, frameBase + slots), empty until bound. A call reserves its frame on top
+    // and releases it in one step on return. Only parameters and locals live here; the
+    // temporaries of expression evaluation are still separate heap objects.
+    std::vector<std::optional<Value>> stack;
+    size_t frameBase = 0;
+    std::vector<Call> calls;  // running calls, innermost last
+    uint64_t callSerial = 0;
+    // Held by pointer so a definition outlives being redefined while it still runs
+    std::unordered_map<Symbol, std::shared_ptr<const Function>> functions;
+    unsigned definitions = 0;
+    std::vector<std::shared_ptr<const CallPlan>> callPlans;  // by token index of the call's '('
     Python3Parser::Atom_exprContext* currentAtomExpr = nullptr;  // for trailer to get callee name
+    // Set by break, continue and return; suites stop after the statement that set it, and the
+    // enclosing loop or call consumes it and resets it to Normal
+    FlowType flow = FlowType::Normal;
+    Value returnValue;
 
-    Value getVar(const std::string& name);
-    void setVar(const std::string& name, const Value& v);
-    void pushScope();
-    void popScope();
+    Symbol intern(const std::string& name);
+    NameRef& nameRef(antlr4::tree::TerminalNode* name);
+    Symbol symbolOf(antlr4::tree::TerminalNode* name) { return nameRef(name).symbol; }
+    void resolveLocals(Python3Parser::FuncdefContext* ctx, Function& f);
+    std::shared_ptr<const CallPlan> callPlan(Python3Parser::TrailerContext* ctx, const Function& fn);
+    std::optional<Value>* localSlot(const NameRef& ref);  // nullptr once an enclosing call has returned
+    Value* findVar(const NameRef& ref);  // nullptr when unbound
+    Value getVar(const NameRef& ref);
+    void setVar(const NameRef& ref, const Value& v);  // rebinds a visible global, else binds locally
     static bool isTrue(const Value& v);
     static std::string formatFloat(double d);
     static Value toInt(const Value& v);
     static Value toFloat(const Value& v);
     static Value toStr(const Value& v);
     static Value toBool(const Value& v);
+    Value evalArith(Python3Parser::Arith_exprContext *ctx);
+    Value evalTerm(Python3Parser::TermContext *ctx);
+    Value evalFactor(Python3Parser::FactorContext *ctx);
+    static Value applyMulOp(Python3Parser::Muldivmod_opContext *op, Value v, const Value& r);
+    static Value callNumberBuiltin(const std::string& name, const std::vector<Value>& args);  // abs, pow, gcd, isqrt
     static int compareValues(const Value& a, const Value& b);
     static Value tryConvertForCompare(const Value& a, const Value& b);
 };
@@ -0,0 +1,89 @@
+#include "LimbPool.h"
+#include <cstdlib>
+#include <new>
+#include <sys/mman.h>
+
+// Size classes are powers of two from MIN_BYTES to POOL_MAX_BYTES
+static constexpr int MIN_CLASS = 6;
+static constexpr int CLASS_COUNT = 15;
+// Bytes each thread keeps cached per size class (at least a few blocks for the large classes)
+static constexpr size_t CACHE_BYTES_PER_CLASS = size_t(1) << 20;
+static constexpr size_t MIN_CACHED_BLOCKS = 4;
+
+namespace {
+struct FreeBlock {
+    FreeBlock* next;
+};
+
+// Set when the thread's cache has been destroyed. Trivially destructible, so unlike the cache
+// it stays readable for the rest of thread teardown; buffers allocated or released after
+// that bypass the cache.
+static thread_local bool cacheClosed = false;
+
+struct ThreadCache {
+    FreeBlock* head[CLASS_COUNT] = {};
+    size_t count[CLASS_COUNT] = {};
+
+    ~ThreadCache() {
+        for (int c = 0; c < CLASS_COUNT; c++) {
+            while (FreeBlock* b = head[c]) {
+                head[c] = b->next;
+                std::free(b);
+            }
+        }
+        cacheClosed = true;
+    }
+};
+}
+
+static thread_local ThreadCache cache;
+
+static int sizeClass(size_t bytes) {
+    return bytes <= LimbPool::MIN_BYTES ? 0 : 64 - __builtin_clzll(bytes - 1) - MIN_CLASS;
+}
+
+void* LimbPool::allocate(size_t& bytes) {
+    if (bytes <= POOL_MAX_BYTES) {
+        int c = sizeClass(bytes);
+        bytes = MIN_BYTES << c;
+        FreeBlock* b = cacheClosed ? nullptr : cache.head[c];
+        if (b) {
+            cache.head[c] = b->next;
+            cache.count[c]--;
+            return b;
+        }
+        void* p = std::malloc(bytes);
+        if (!p) throw std::bad_alloc();
+        return p;
+    }
+    if (bytes < HUGE_BYTES) {
+        void* p = std::malloc(bytes);
+        if (!p) throw std::bad_alloc();
+        return p;
+    }
+    bytes = (bytes + HUGE_BYTES - 1) / HUGE_BYTES * HUGE_BYTES;
+    void* p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) throw std::bad_alloc();
+#ifdef MADV_HUGEPAGE
+    madvise(p, bytes, MADV_HUGEPAGE);
+#endif
+    return p;
+}
+
+void LimbPool::deallocate(void* p, size_t bytes) {
+    if (bytes <= POOL_MAX_BYTES) {
+        int c = sizeClass(bytes);
+        if (!cacheClosed && (cache.count[c] < MIN_CACHED_BLOCKS || cache.count[c] * bytes < CACHE_BYTES_PER_CLASS)) {
+            FreeBlock* b = static_cast<FreeBlock*>(p);
+            b->next = cache.head[c];
+            cache.head[c] = b;
+            cache.count[c]++;
+            return;
+        }
+        std::free(p);
+    } else if (bytes < HUGE_BYTES) {
+        std::free(p);
+    } else {
+        munmap(p, bytes);
+    }
+}
@@ -0,0 +1,23 @@
+#pragma once
+#ifndef PYTHON_INTERPRETER_LIMBPOOL_H
+#define PYTHON_INTERPRETER_LIMBPOOL_H
+
+#include <cstddef>
+
+// Allocator behind LimbVector's heap buffers. Blocks up to POOL_MAX_BYTES are rounded up to a
+// power of two and recycled through per-thread free lists, so the temporaries of BigInt
+// arithmetic stop going through malloc. Blocks of HUGE_BYTES and more are mapped directly
+// and advised onto transparent huge pages; sizes in between use malloc.
+class LimbPool {
+public:
+    static constexpr size_t MIN_BYTES = 64;
+    static constexpr size_t POOL_MAX_BYTES = size_t(1) << 20;
+    static constexpr size_t HUGE_BYTES = size_t(2) << 20;
+
+    // Returns at least `bytes` bytes; `bytes` is updated to the usable size, which is
+    // what deallocate() must be given back.
+    static void* allocate(size_t& bytes);
+    static void deallocate(void* p, size_t bytes);
+};
+
+#endif
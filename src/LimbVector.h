@@ -0,0 +1,142 @@
+#pragma once
+#ifndef PYTHON_INTERPRETER_LIMBVECTOR_H
+#define PYTHON_INTERPRETER_LIMBVECTOR_H
+
+#include "LimbPool.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+// Limb storage for BigInt: a minimal vector with room for a few limbs inside the object,
+// so values up to 128 bits never allocate. Larger buffers live on the heap behind a
+// reference count and are shared by copies; a shared buffer is cloned only when one of its
+// owners is about to write to it (non-const data(), push_back, resize, ...). Heap buffers
+// come from LimbPool, which rounds their size up; the extra room becomes capacity.
+class LimbVector {
+public:
+    using Limb = uint32_t;
+    static constexpr uint32_t INLINE_LIMBS = 4;
+
+    LimbVector() {}
+    explicit LimbVector(size_t n) { resize(n, 0); }
+    LimbVector(const LimbVector& o) { share(o); }
+    LimbVector(LimbVector&& o) noexcept { steal(o); }
+    ~LimbVector() { release(); }
+
+    LimbVector& operator=(const LimbVector& o) {
+        if (this != &o) { release(); share(o); }
+        return *this;
+    }
+    LimbVector& operator=(LimbVector&& o) noexcept {
+        if (this != &o) { release(); steal(o); }
+        return *this;
+    }
+
+    size_t size() const { return n; }
+    size_t capacity() const { return cap; }
+    bool empty() const { return n == 0; }
+    Limb* data() {
+        if (isInline()) return local;
+        if (!unique()) grow(cap);
+        return heap;
+    }
+    const Limb* data() const { return isInline() ? local : heap; }
+    Limb* begin() { return data(); }
+    Limb* end() { return data() + n; }
+    const Limb* begin() const { return data(); }
+    const Limb* end() const { return data() + n; }
+    Limb& operator[](size_t i) { return data()[i]; }
+    Limb operator[](size_t i) const { return data()[i]; }
+    Limb& back() { return data()[n - 1]; }
+    Limb back() const { return data()[n - 1]; }
+
+    void reserve(size_t c) { if (c > cap) grow(c); }
+    void clear() { n = 0; }
+    void push_back(Limb v) {
+        if (n == cap) grow(size_t(cap) * 2);
+        data()[n++] = v;
+    }
+    void pop_back() { n--; }
+    void resize(size_t m, Limb v = 0) {
+        reserve(m);
+        if (m > n) std::fill(data() + n, data() + m, v);
+        n = (uint32_t)m;
+    }
+    void assign(size_t m, Limb v) {
+        n = 0;
+        resize(m, v);
+    }
+    void assign(const Limb* first, const Limb* last) {  // the range may be in a buffer this shares
+        size_t m = last - first;
+        if (!isInline() && !unique()) release();
+        reserve(m);
+        std::memmove(data(), first, m * sizeof(Limb));
+        n = (uint32_t)m;
+    }
+    void swap(LimbVector& o) noexcept {
+        LimbVector t(std::move(o));
+        o = std::move(*this);
+        *this = std::move(t);
+    }
+
+    bool operator==(const LimbVector& o) const {
+        return n == o.n && std::equal(begin(), end(), o.begin());
+    }
+    bool operator!=(const LimbVector& o) const { return !(*this == o); }
+
+private:
+    // A heap buffer is preceded by its reference count
+    struct Header {
+        uint32_t refs;
+        uint32_t reserved;
+    };
+
+    uint32_t n = 0, cap = INLINE_LIMBS;  // cap == INLINE_LIMBS exactly when the limbs are local
+    union {
+        Limb* heap;
+        Limb local[INLINE_LIMBS];
+    };
+
+    bool isInline() const { return cap == INLINE_LIMBS; }
+    Header* header() const { return (Header*)heap - 1; }
+    bool unique() const { return __atomic_load_n(&header()->refs, __ATOMIC_ACQUIRE) == 1; }
+
+    // Moves to a buffer of capacity >= c (and >= n), leaving this as its only owner
+    void grow(size_t c) {
+        size_t bytes = sizeof(Header) + std::max<size_t>(c, INLINE_LIMBS + 1) * sizeof(Limb);
+        Header* h = (Header*)LimbPool::allocate(bytes);
+        h->refs = 1;
+        std::memcpy(h + 1, isInline() ? local : heap, n * sizeof(Limb));
+        uint32_t keep = n;
+        release();
+        n = keep;
+        heap = (Limb*)(h + 1);
+        cap = (uint32_t)((bytes - sizeof(Header)) / sizeof(Limb));
+    }
+    void release() {
+        if (!isInline() && __atomic_sub_fetch(&header()->refs, 1, __ATOMIC_ACQ_REL) == 0)
+            LimbPool::deallocate(header(), sizeof(Header) + cap * sizeof(Limb));
+        n = 0;
+        cap = INLINE_LIMBS;
+    }
+    void share(const LimbVector& o) {
+        n = o.n;
+        cap = o.cap;
+        if (o.isInline()) {
+            std::memcpy(local, o.local, n * sizeof(Limb));  // only the limbs in use are set
+        } else {
+            heap = o.heap;
+            __atomic_fetch_add(&header()->refs, 1, __ATOMIC_RELAXED);
+        }
+    }
+    void steal(LimbVector& o) {
+        n = o.n;
+        cap = o.cap;
+        if (o.isInline()) std::memcpy(local, o.local, n * sizeof(Limb));
+        else heap = o.heap;
+        o.n = 0;
+        o.cap = INLINE_LIMBS;
+    }
+};
+
+#endif
@@ -0,0 +1,103 @@
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cstdint>
+
+static std::unique_ptr<ThreadPool> pool;
+static thread_local size_t workerIndex = SIZE_MAX;  // queue owned by this thread, if it is a worker
+
+void ThreadPool::start(unsigned threads) {
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    pool.reset();
+    if (threads > 1) pool.reset(new ThreadPool(threads - 1));  // the calling thread is the last one
+}
+
+void ThreadPool::invoke(std::initializer_list<std::function<void()>> tasks, bool parallel) {
+    if (pool && parallel && tasks.size() > 1) {
+        pool->fork(tasks);
+        return;
+    }
+    for (const auto& fn : tasks) fn();
+}
+
+ThreadPool::ThreadPool(unsigned workerCount) {
+    for (unsigned i = 0; i <= workerCount; i++) queues.emplace_back(new Queue);
+    for (unsigned i = 0; i < workerCount; i++) workers.emplace_back(&ThreadPool::workerLoop, this, i);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lk(sleepLock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& t : workers) t.join();
+}
+
+// ============== Fork-join ==============
+void ThreadPool::fork(std::initializer_list<std::function<void()>> fns) {
+    size_t n = fns.size(), self = selfQueue();
+    std::unique_ptr<Task[]> tasks(new Task[n]);
+    auto it = fns.begin();
+    for (size_t i = 0; i < n; i++) tasks[i].fn = *it++;
+    // Pushed in reverse so this thread pops them back in order; idle workers steal from the front
+    for (size_t i = n; --i;) push(self, &tasks[i]);
+    run(&tasks[0]);
+    for (size_t i = 1; i < n; i++) {
+        while (!tasks[i].done.load(std::memory_order_acquire)) {
+            if (Task* t = take(self)) run(t);
+            else std::this_thread::yield();
+        }
+    }
+    for (size_t i = 0; i < n; i++) {
+        if (tasks[i].error) std::rethrow_exception(tasks[i].error);
+    }
+}
+
+size_t ThreadPool::selfQueue() const {
+    return workerIndex == SIZE_MAX ? queues.size() - 1 : workerIndex;
+}
+
+void ThreadPool::push(size_t self, Task* t) {
+    {
+        std::lock_guard<std::mutex> lk(queues[self]->lock);
+        queues[self]->tasks.push_back(t);
+        queued.fetch_add(1, std::memory_order_release);
+    }
+    { std::lock_guard<std::mutex> lk(sleepLock); }  // a worker between its check and its wait sees the push
+    wake.notify_one();
+}
+
+ThreadPool::Task* ThreadPool::take(size_t self) {
+    if (queued.load(std::memory_order_acquire) == 0) return nullptr;
+    size_t count = queues.size();
+    for (size_t k = 0; k < count; k++) {
+        Queue& q = *queues[(self + k) % count];
+        std::lock_guard<std::mutex> lk(q.lock);
+        if (q.tasks.empty()) continue;
+        Task* t;
+        if (k == 0) { t = q.tasks.back(); q.tasks.pop_back(); }
+        else { t = q.tasks.front(); q.tasks.pop_front(); }
+        queued.fetch_sub(1, std::memory_order_relaxed);
+        return t;
+    }
+    return nullptr;
+}
+
+void ThreadPool::run(Task* t) {
+    try {
+        t->fn();
+    } catch (...) {
+        t->error = std::current_exception();
+    }
+    t->done.store(true, std::memory_order_release);
+}
+
+void ThreadPool::workerLoop(size_t self) {
+    workerIndex = self;
+    for (;;) {
+        if (Task* t = take(self)) { run(t); continue; }
+        std::unique_lock<std::mutex> lk(sleepLock);
+        wake.wait(lk, [this] { return stopping || queued.load(std::memory_order_acquire) > 0; });
+        if (stopping) return;
+    }
+}
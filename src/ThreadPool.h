@@ -0,0 +1,59 @@
+#pragma once
+#ifndef PYTHON_INTERPRETER_THREADPOOL_H
+#define PYTHON_INTERPRETER_THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work-stealing pool for fork-join parallelism inside BigInt arithmetic. It is off until
+// start() is called; until then invoke() simply runs its tasks one after another.
+// Every worker owns a deque: it pushes and pops its own tasks at the back and steals from
+// the front of the others. A thread waiting in invoke() keeps running tasks meanwhile, so
+// tasks may fork again without tying up a worker.
+class ThreadPool {
+public:
+    static void start(unsigned threads);  // 0 = one per hardware thread; 1 keeps everything serial
+
+    // Runs every task and returns once all have finished, spreading them over the pool when
+    // one is running and `parallel` is set. The first exception a task throws is rethrown.
+    static void invoke(std::initializer_list<std::function<void()>> tasks, bool parallel = true);
+
+    ~ThreadPool();
+
+private:
+    struct Task {
+        std::function<void()> fn;
+        std::exception_ptr error;
+        std::atomic<bool> done{false};
+    };
+    struct Queue {
+        std::mutex lock;
+        std::deque<Task*> tasks;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues;  // one per worker, the last for outside threads
+    std::vector<std::thread> workers;
+    std::mutex sleepLock;
+    std::condition_variable wake;
+    std::atomic<size_t> queued{0};
+    bool stopping = false;
+
+    explicit ThreadPool(unsigned workerCount);
+    void fork(std::initializer_list<std::function<void()>> tasks);
+    size_t selfQueue() const;
+    void push(size_t self, Task* t);
+    Task* take(size_t self);
+    static void run(Task* t);
+    void workerLoop(size_t self);
+};
+
+#endif
@@ -0,0 +1,219 @@
+// Re-executes a BigInt trace written by `code --trace-bigint=FILE` against the BigInt
+// library alone and reports the time spent per operation as JSON on stdout.
+//
+//   bigint_replay TRACE [--repeat=N]
+//
+// Operands traced as values are used as recorded. Size-only operands are replaced by
+// pseudo-random numbers with the recorded sign and exactly the recorded limb count; one
+// such number is made per (size, sign, operand position), so `mul L9 L9` still multiplies
+// two different numbers. Operand setup happens before the timed run.
+#include "BigInt.h"
+#include "BigIntTrace.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+enum class OpKind {
+    Add, Sub, Mul, FloorDiv, Mod, DivMod, Neg, IAdd, ISub, IMul, AddMul, SubMul,
+    Compare, Abs, Pow, PowMod, Gcd, Isqrt, Parse, Str
+};
+
+static const std::map<std::string, std::pair<OpKind, size_t>> OP_TABLE = {  // name -> kind, operand count
+    {"add", {OpKind::Add, 2}},         {"sub", {OpKind::Sub, 2}},       {"mul", {OpKind::Mul, 2}},
+    {"floordiv", {OpKind::FloorDiv, 2}}, {"mod", {OpKind::Mod, 2}},     {"divmod", {OpKind::DivMod, 2}},
+    {"neg", {OpKind::Neg, 1}},         {"iadd", {OpKind::IAdd, 2}},     {"isub", {OpKind::ISub, 2}},
+    {"imul", {OpKind::IMul, 2}},       {"addmul", {OpKind::AddMul, 3}}, {"submul", {OpKind::SubMul, 3}},
+    {"compare", {OpKind::Compare, 2}}, {"abs", {OpKind::Abs, 1}},       {"pow", {OpKind::Pow, 1}},
+    {"powmod", {OpKind::PowMod, 3}},   {"gcd", {OpKind::Gcd, 2}},       {"isqrt", {OpKind::Isqrt, 1}},
+    {"parse", {OpKind::Parse, 1}},     {"str", {OpKind::Str, 1}},
+};
+
+struct Op {
+    OpKind kind;
+    std::string name;
+    size_t args[3];  // indices into the operand pool
+    long long word;
+    std::string text;  // decimal text of the operand, for parse
+};
+
+struct Stats {
+    size_t count = 0;
+    double ns = 0;
+};
+
+// ============== Loading ==============
+// A number with exactly `limbs` 32-bit limbs: d decimal digits with
+// 2^(32(limbs-1)) <= 10^(d-1) and 10^d <= 2^(32 limbs); such a d always exists
+static BigInt numberWithLimbs(size_t limbs, bool negative, std::mt19937_64& rng) {
+    if (limbs == 0) return BigInt(0);
+    const long double log10of2 = 0.30102999566398119521L;
+    size_t d = (size_t)std::ceil(32.0L * (limbs - 1) * log10of2) + 1;
+    std::string s(d, '0');
+    s[0] = '1' + rng() % 9;
+    for (size_t i = 1; i < d; i++) s[i] = '0' + rng() % 10;
+    BigInt x(s);
+    return negative ? -x : x;
+}
+
+class TraceLoader {
+public:
+    std::vector<BigInt> pool;
+    std::vector<Op> ops;
+
+    bool load(const std::string& path) {
+        std::ifstream in(path);
+        std::string line;
+        if (!std::getline(in, line) || line != BigIntTrace::HEADER) {
+            std::cerr << "bigint_replay: " << path << " is not a BigInt trace\n";
+            return false;
+        }
+        for (size_t lineNo = 2; std::getline(in, line); lineNo++) {
+            if (line.empty()) continue;
+            if (!parseLine(line)) {
+                std::cerr << "bigint_replay: bad line " << lineNo << ": " << line << "\n";
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    std::map<std::tuple<size_t, bool, size_t>, size_t> sized;  // (limbs, sign, position) -> pool index
+    std::mt19937_64 rng{20240101};
+
+    size_t operand(const std::string& tok, size_t position) {
+        if (tok[0] == 'V') {
+            pool.emplace_back(tok.substr(1));
+            return pool.size() - 1;
+        }
+        bool negative = tok[0] == '-';
+        size_t limbs = std::stoull(tok.substr(negative ? 2 : 1));
+        auto key = std::make_tuple(limbs, negative, position);
+        auto it = sized.find(key);
+        if (it != sized.end()) return it->second;
+        pool.push_back(numberWithLimbs(limbs, negative, rng));
+        return sized[key] = pool.size() - 1;
+    }
+
+    bool parseLine(const std::string& line) {
+        std::istringstream ss(line);
+        std::string name, tok;
+        ss >> name;
+        auto it = OP_TABLE.find(name);
+        if (it == OP_TABLE.end()) return false;
+        Op op{it->second.first, name, {0, 0, 0}, 0, ""};
+        size_t n = 0;
+        while (ss >> tok) {
+            if (tok[0] == 'E') op.word = std::stoll(tok.substr(1));
+            else if (n < 3 && (tok[0] == 'V' || tok[0] == 'L' || tok.compare(0, 2, "-L") == 0)) {
+                op.args[n] = operand(tok, n);
+                n++;
+            } else {
+                return false;
+            }
+        }
+        if (n != it->second.second) return false;
+        if (op.kind == OpKind::Parse) op.text = pool[op.args[0]].toString();
+        ops.push_back(std::move(op));
+        return true;
+    }
+};
+
+// ============== Replay ==============
+static size_t sink = 0;  // keeps results observable so no work is optimized away
+
+static void run(const Op& op, const std::vector<BigInt>& pool) {
+    const BigInt& a = pool[op.args[0]];
+    const BigInt& b = pool[op.args[1]];
+    const BigInt& c = pool[op.args[2]];
+    switch (op.kind) {
+    case OpKind::Add: sink += (a + b).isZero(); break;
+    case OpKind::Sub: sink += (a - b).isZero(); break;
+    case OpKind::Mul: sink += (a * b).isZero(); break;
+    case OpKind::FloorDiv: sink += (a / b).isZero(); break;
+    case OpKind::Mod: sink += (a % b).isZero(); break;
+    case OpKind::DivMod: {
+        BigInt q, r;
+        BigInt::divMod(a, b, q, r);
+        sink += q.isZero() + r.isZero();
+        break;
+    }
+    case OpKind::Neg: sink += (-a).isZero(); break;
+    // In-place forms start from a copy, which shares the buffer until the first write
+    case OpKind::IAdd: { BigInt x = a; x += b; sink += x.isZero(); break; }
+    case OpKind::ISub: { BigInt x = a; x -= b; sink += x.isZero(); break; }
+    case OpKind::IMul: { BigInt x = a; x *= b; sink += x.isZero(); break; }
+    case OpKind::AddMul: { BigInt x = a; x.addMul(b, c); sink += x.isZero(); break; }
+    case OpKind::SubMul: { BigInt x = a; x.subMul(b, c); sink += x.isZero(); break; }
+    case OpKind::Compare: sink += a < b; break;
+    case OpKind::Abs: sink += a.abs().isZero(); break;
+    case OpKind::Pow: sink += a.pow((unsigned long long)op.word).isZero(); break;
+    case OpKind::PowMod: sink += BigInt::powMod(a, b, c).isZero(); break;
+    case OpKind::Gcd: sink += BigInt::gcd(a, b).isZero(); break;
+    case OpKind::Isqrt: sink += a.isqrt().isZero(); break;
+    case OpKind::Parse: sink += BigInt(op.text).isZero(); break;
+    case OpKind::Str: sink += a.toString().size(); break;
+    }
+}
+
+int main(int argc, char** argv) {
+    std::string path;
+    int repeat = 1;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.compare(0, 9, "--repeat=") == 0) repeat = std::max(1, std::stoi(arg.substr(9)));
+        else if (path.empty() && arg[0] != '-') path = arg;
+        else {
+            std::cerr << "usage: bigint_replay TRACE [--repeat=N]\n";
+            return 2;
+        }
+    }
+    if (path.empty()) {
+        std::cerr << "usage: bigint_replay TRACE [--repeat=N]\n";
+        return 2;
+    }
+    TraceLoader trace;
+    if (!trace.load(path)) return 1;
+
+    using Clock = std::chrono::steady_clock;
+    std::map<std::string, Stats> stats;
+    size_t errors = 0;
+    double total = 0;
+    for (int r = 0; r < repeat; r++) {
+        for (const Op& op : trace.ops) {
+            auto t0 = Clock::now();
+            try {
+                run(op, trace.pool);
+            } catch (const std::exception&) {
+                errors++;  // e.g. a division by zero that also failed in the traced script
+            }
+            double ns = std::chrono::duration<double, std::nano>(Clock::now() - t0).count();
+            Stats& s = stats[op.name];
+            s.count++;
+            s.ns += ns;
+            total += ns;
+        }
+    }
+
+    std::cout << "{\n  \"trace\": \"" << path << "\",\n  \"operations\": " << trace.ops.size()
+              << ",\n  \"repeat\": " << repeat << ",\n  \"errors\": " << errors
+              << ",\n  \"total_ns\": " << (long long)(total / repeat) << ",\n  \"ops\": [\n";
+    size_t i = 0;
+    for (const auto& [name, s] : stats) {
+        char line[256];
+        std::snprintf(line, sizeof(line), "    {\"op\": \"%s\", \"count\": %zu, \"total_ns\": %.0f, \"ns_per_op\": %.1f}%s\n",
+                      name.c_str(), s.count / repeat, s.ns / repeat, s.ns / s.count, ++i < stats.size() ? "," : "");
+        std::cout << line;
+    }
+    std::cout << "  ],\n  \"sink\": " << sink << "\n}\n";
+    return 0;
+}